@@ -0,0 +1,325 @@
+// batch.cpp : Runs large batches of headless Space Invaders games in parallel, and writes their results to a CSV file.
+//
+
+#include "../SpaceInvaders/StdAfx.h"
+#include "../SpaceInvaders/model.h"
+#include "../SpaceInvaders/stats.h"
+#include <mutex>
+#include <atomic>
+
+using namespace SI;
+
+// The options the batch runner can be run with
+struct Options {
+	// The directory containing the level files
+	std::string levelDirectory = "Assets/levels/";
+
+	// The file the results get written to
+	std::string outFile = "results.csv";
+
+	// An optional input script to play every game with, instead of the sweeping script
+	std::string scriptFile;
+
+	// The number of games to run per level
+	unsigned int games = 100;
+
+	// The number of levels a game plays before it counts as won, starting from its own level
+	unsigned int levelsPerGame = 1;
+
+	// The number of worker threads, 0 for one per core
+	unsigned int threads = 0;
+
+	// The length of a single simulation step in seconds
+	double stepLength = 1.0 / 120.0;
+
+	// The maximum number of simulated seconds a game may last
+	double maxSeconds = 600;
+
+	// The number of steps the scripted player moves in one direction before turning around
+	unsigned int sweepPeriod = 120;
+
+	// The seed of the first game, every next game uses the next seed
+	std::uint64_t seed = RNG::RNG::randomSeed();
+
+	// How the model finds colliding entities
+	Md::CollisionMode collisionMode = Md::CollisionMode::bruteForce;
+};
+
+// A single game to run
+struct Job {
+	// The level the game starts at
+	unsigned int level;
+
+	// The number of the game within its level
+	unsigned int game;
+
+	// The seed of the game's RNG
+	std::uint64_t seed;
+};
+
+// The outcome of a single game
+struct Result {
+	// Whether the game was won, lost or cut off
+	std::string result;
+
+	// The number of levels completed
+	unsigned int levelsCompleted;
+
+	// The number of steps the game lasted
+	unsigned long long steps;
+
+	// The number of enemies and barriers destroyed
+	unsigned int enemiesDestroyed, barriersDestroyed;
+
+	// The number of shots the player fired, and the number of times the player got hit
+	unsigned int shotsFired, playerHits;
+
+	// The number of lives the player had left
+	int lives;
+};
+
+// Hands out job indices to worker threads
+// Every worker starts with its own contiguous range of jobs, and once it runs out it steals the back half
+// of another worker's remaining range, so that workers finishing early keep busy without contending on a single counter
+class JobQueue {
+private:
+	// A range of job indices [begin, end)
+	struct Range {
+		std::mutex mutex;
+		unsigned int begin, end;
+	};
+
+	std::vector<std::unique_ptr<Range>> ranges;
+
+public:
+	JobQueue(unsigned int jobs, unsigned int workers) {
+		for (unsigned int w = 0; w < workers; ++w) {
+			ranges.push_back(std::unique_ptr<Range>(new Range));
+			ranges[w]->begin = (unsigned long long)jobs * w / workers;
+			ranges[w]->end = (unsigned long long)jobs * (w + 1) / workers;
+		}
+	}
+
+	// Get the next job for a worker, returns false once there are no jobs left anywhere
+	bool pop(unsigned int worker, unsigned int& job) {
+		Range& own = *ranges[worker];
+		{
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (own.begin < own.end) {
+				job = own.begin++;
+				return true;
+			}
+		}
+
+		for (unsigned int i = 1; i < ranges.size(); ++i) {
+			Range& victim = *ranges[(worker + i) % ranges.size()];
+			unsigned int begin, end;
+			{
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (victim.begin >= victim.end)
+					continue;
+				begin = victim.begin + (victim.end - victim.begin) / 2;
+				end = victim.end;
+				victim.end = begin;
+			}
+			// Our own range is empty, so nobody steals from it in the meantime
+			std::lock_guard<std::mutex> lock(own.mutex);
+			job = begin;
+			own.begin = begin + 1;
+			own.end = end;
+			return true;
+		}
+		return false;
+	}
+};
+
+void printUsage() {
+	std::cout << "Usage: SpaceInvadersBatch [options]" << std::endl;
+	std::cout << "  --levels <dir>         directory containing the level files (default: Assets/levels/)" << std::endl;
+	std::cout << "  --out <file>           CSV file to write the results to (default: results.csv)" << std::endl;
+	std::cout << "  --script <file>        input script to play with instead of sweeping and shooting" << std::endl;
+	std::cout << "  --games <n>            games to run per level (default: 100)" << std::endl;
+	std::cout << "  --levels-per-game <n>  levels a game must complete to count as won (default: 1)" << std::endl;
+	std::cout << "  --threads <n>          worker threads, 0 for one per core (default: 0)" << std::endl;
+	std::cout << "  --step <seconds>       length of a simulation step (default: 1/120)" << std::endl;
+	std::cout << "  --max-seconds <s>      simulated time after which a game is cut off (default: 600)" << std::endl;
+	std::cout << "  --sweep <steps>        steps the scripted player moves each way (default: 120)" << std::endl;
+	std::cout << "  --seed <n>             seed of the first game (default: random)" << std::endl;
+	std::cout << "  --collision <mode>     grid or brute, how colliding entities are found (default: brute)" << std::endl;
+}
+
+Options parseOptions(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--help") {
+			printUsage();
+			std::exit(0);
+		}
+		if (i + 1 == argc)
+			throw(std::runtime_error("Missing value for option \"" + arg + "\"."));
+		std::string value = argv[++i];
+
+		if (arg == "--levels")
+			options.levelDirectory = value;
+		else if (arg == "--out")
+			options.outFile = value;
+		else if (arg == "--script")
+			options.scriptFile = value;
+		else if (arg == "--games")
+			options.games = std::stoul(value);
+		else if (arg == "--levels-per-game")
+			options.levelsPerGame = std::stoul(value);
+		else if (arg == "--threads")
+			options.threads = std::stoul(value);
+		else if (arg == "--step")
+			options.stepLength = std::stod(value);
+		else if (arg == "--max-seconds")
+			options.maxSeconds = std::stod(value);
+		else if (arg == "--sweep")
+			options.sweepPeriod = std::stoul(value);
+		else if (arg == "--seed")
+			options.seed = std::stoull(value);
+		else if (arg == "--collision") {
+			if (value == "grid")
+				options.collisionMode = Md::CollisionMode::uniformGrid;
+			else if (value == "brute")
+				options.collisionMode = Md::CollisionMode::bruteForce;
+			else
+				throw(std::runtime_error("Unrecognised collision mode \"" + value + "\", expected grid or brute."));
+		}
+		else
+			throw(std::runtime_error("Unrecognised option \"" + arg + "\"."));
+	}
+	return options;
+}
+
+// Play a single game to its end
+Result runGame(const Options& options, const std::vector<std::shared_ptr<Md::Level>>& levels, const std::vector<Ctrl::InputState>& script, const Job& job) {
+	Md::Model model(options.stepLength, 8, levels);
+	model.setCollisionMode(options.collisionMode);
+
+	auto stats = std::make_shared<Md::StatsObserver>();
+	model.registerObserver(stats);
+	model.registerInputSource(std::make_shared<Ctrl::ScriptedInput>(script));
+	model.seed(job.seed);
+	model.reset(job.level);
+
+	unsigned long long maxSteps = (unsigned long long)(options.maxSeconds / options.stepLength);
+	unsigned long long steps = 0;
+	while (!stats->isFinished() && stats->getLevelsCompleted() < options.levelsPerGame && steps < maxSteps) {
+		model.step();
+		++steps;
+	}
+
+	Result result;
+	if (stats->getLevelsCompleted() >= options.levelsPerGame || stats->getState() == Md::ModelState::victory)
+		result.result = "won";
+	else if (stats->getState() == Md::ModelState::gameOver)
+		result.result = "lost";
+	else
+		result.result = "cut off";
+	result.levelsCompleted = stats->getLevelsCompleted();
+	result.steps = steps;
+	result.enemiesDestroyed = stats->getEnemiesDestroyed();
+	result.barriersDestroyed = stats->getEventCount(Md::barrierDestroyed);
+	result.shotsFired = stats->getEventCount(Md::friendlyShotFired);
+	result.playerHits = stats->getEventCount(Md::friendlyHit);
+	result.lives = stats->getLives();
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	try {
+		Options options = parseOptions(argc, argv);
+
+		// Everything shared between the workers is prepared up front, and only read from then on
+		std::vector<std::shared_ptr<Md::Level>> levels = Md::LevelParser(options.levelDirectory).parseLevels();
+		if (levels.empty())
+			throw(std::runtime_error("No levels found in \"" + options.levelDirectory + "\"."));
+
+		std::vector<Ctrl::InputState> script = Ctrl::ScriptedInput::sweep(options.sweepPeriod);
+		if (!options.scriptFile.empty()) {
+			std::ifstream file(options.scriptFile);
+			if (!file)
+				throw(std::runtime_error("Failed to open script file: " + options.scriptFile));
+			script = Ctrl::ScriptedInput::parse(file);
+			if (script.empty())
+				throw(std::runtime_error("Script file is empty: " + options.scriptFile));
+		}
+
+		std::vector<Job> jobs;
+		for (unsigned int level = 0; level < levels.size(); ++level)
+			for (unsigned int game = 0; game < options.games; ++game)
+				jobs.push_back({ level, game, options.seed + jobs.size() });
+		std::vector<Result> results(jobs.size());
+
+		unsigned int threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+		std::cout << "Running " << jobs.size() << " games on " << threads << " threads, starting at seed " << options.seed << "..." << std::endl;
+
+		// Every worker writes only the results of the jobs it popped, so no further synchronisation is needed
+		JobQueue queue((unsigned int)jobs.size(), threads);
+		std::atomic<bool> failed(false);
+		std::string failure;
+		std::mutex failureMutex;
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for (unsigned int w = 0; w < threads; ++w)
+			workers.emplace_back([&, w]() {
+				try {
+					unsigned int job;
+					while (!failed && queue.pop(w, job))
+						results[job] = runGame(options, levels, script, jobs[job]);
+				} catch (std::exception& e) {
+					std::lock_guard<std::mutex> lock(failureMutex);
+					failed = true;
+					failure = e.what();
+				}
+			});
+		for (auto& worker : workers)
+			worker.join();
+		double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (failed)
+			throw(std::runtime_error(failure));
+
+		// Write every game's results
+		std::ofstream out(options.outFile);
+		if (!out)
+			throw(std::runtime_error("Failed to open output file: " + options.outFile));
+		out << "level,level name,game,seed,result,levels completed,steps,simulated seconds,enemies destroyed,barriers destroyed,shots fired,player hits,lives" << std::endl;
+		unsigned long long totalSteps = 0;
+		for (unsigned int i = 0; i < jobs.size(); ++i) {
+			const Job& job = jobs[i];
+			const Result& r = results[i];
+			out << job.level << ",\"" << levels[job.level]->getName() << "\"," << job.game << "," << job.seed << "," << r.result << ","
+				<< r.levelsCompleted << "," << r.steps << "," << r.steps * options.stepLength << ","
+				<< r.enemiesDestroyed << "," << r.barriersDestroyed << "," << r.shotsFired << "," << r.playerHits << "," << r.lives << std::endl;
+			totalSteps += r.steps;
+		}
+
+		// Summarise per level
+		for (unsigned int level = 0; level < levels.size(); ++level) {
+			unsigned int won = 0;
+			unsigned long long steps = 0;
+			for (unsigned int i = 0; i < jobs.size(); ++i)
+				if (jobs[i].level == level) {
+					won += results[i].result == "won";
+					steps += results[i].steps;
+				}
+			std::cout << "Level " << level << " (" << levels[level]->getName() << "): won " << won << "/" << options.games
+				<< ", average simulated seconds: " << (options.games ? steps * options.stepLength / options.games : 0) << std::endl;
+		}
+		std::cout << "Simulated " << totalSteps << " steps in " << wallSeconds << " seconds (" << totalSteps / wallSeconds << " steps per second)." << std::endl;
+		std::cout << "Results written to " << options.outFile << std::endl;
+
+	} catch (std::exception& e) {
+		std::cout << "\nException encountered!" << std::endl;
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,421 @@
+// bench.cpp : Microbenchmarks of the simulation, run headless from the command line.
+//
+
+#include "../SpaceInvaders/StdAfx.h"
+#include "../SpaceInvaders/model.h"
+#include "../SpaceInvaders/stats.h"
+#include "../SpaceInvaders/pacer.h"
+
+#include <ctime>
+
+using namespace SI;
+
+// The options the benchmarks can be run with
+struct Options {
+	// The directory containing the level files
+	std::string levelDirectory = "Assets/levels/";
+
+	// The benchmark to run, or every benchmark if empty
+	std::string benchmark;
+
+	// The number of seconds to spend on each measurement
+	double seconds = 1.0;
+};
+
+void printUsage() {
+	std::cout << "Usage: SpaceInvadersBench [options] [benchmark]" << std::endl;
+	std::cout << "  --levels <dir>     directory containing the level files (default: Assets/levels/)" << std::endl;
+	std::cout << "  --seconds <s>      time spent on each measurement (default: 1)" << std::endl;
+	std::cout << "Benchmarks: snapshot, rollback, cluster, observe, shots, timers, clocks, events, pacing, collision" << std::endl;
+}
+
+Options parseOptions(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--help") {
+			printUsage();
+			std::exit(0);
+		}
+		if (arg.compare(0, 2, "--") != 0) {
+			options.benchmark = arg;
+			continue;
+		}
+		if (i + 1 == argc)
+			throw(std::runtime_error("Missing value for option \"" + arg + "\"."));
+		std::string value = argv[++i];
+
+		if (arg == "--levels")
+			options.levelDirectory = value;
+		else if (arg == "--seconds")
+			options.seconds = std::stod(value);
+		else
+			throw(std::runtime_error("Unrecognised option \"" + arg + "\"."));
+	}
+	return options;
+}
+
+// Run 'f' in batches until 'seconds' have passed, returns the number of calls per second
+template <typename F>
+double measure(double seconds, F f) {
+	unsigned long long calls = 0;
+	auto start = std::chrono::steady_clock::now();
+	double elapsed = 0;
+	while (elapsed < seconds) {
+		for (unsigned int i = 0; i < 1000; ++i)
+			f();
+		calls += 1000;
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	return calls / elapsed;
+}
+
+// Measure taking and restoring snapshots of every level, a few seconds into the level
+void benchSnapshot(const Options& options, const std::vector<std::shared_ptr<Md::Level>>& levels) {
+	std::cout << "snapshot: save + restore pairs per second, per level" << std::endl;
+	for (unsigned int level = 0; level < levels.size(); ++level) {
+		Md::Model model(1.0 / 120.0, 8, levels);
+		model.registerInputSource(std::make_shared<Ctrl::ScriptedInput>(Ctrl::ScriptedInput::sweep(120)));
+		model.seed(level);
+		model.reset(level);
+		for (unsigned int i = 0; i < 600; ++i)
+			model.step();
+
+		Snapshot snapshot;
+		model.saveSnapshot(snapshot);
+		double pairs = measure(options.seconds, [&]() {
+			model.saveSnapshot(snapshot);
+			model.loadSnapshot(snapshot, false);
+		});
+		std::cout << "  level " << level << " (" << levels[level]->getName() << "): " << (unsigned long long)pairs
+			<< " pairs/s, " << snapshot.size() << " bytes" << std::endl;
+	}
+}
+
+// Measure netplay rollbacks of 8 steps on every level with two players and a view's observer, a few seconds into the level
+// Every rollback restores a snapshot and simulates the steps again while taking snapshots, as RollbackSession does
+void benchRollback(const Options& options, const std::vector<std::shared_ptr<Md::Level>>& levels) {
+	const unsigned int depth = 8;
+	std::cout << "rollback: microseconds per rollback of " << depth << " steps, per level" << std::endl;
+	for (unsigned int level = 0; level < levels.size(); ++level) {
+		Md::Model model(1.0 / 120.0, 8, levels);
+		model.setPlayerCount(2);
+		model.registerInputSource(std::make_shared<Ctrl::ScriptedInput>(Ctrl::ScriptedInput::sweep(90)), 0);
+		model.registerInputSource(std::make_shared<Ctrl::ScriptedInput>(Ctrl::ScriptedInput::sweep(130)), 1);
+		model.registerObserver(std::make_shared<Md::MirrorObserver>());
+		model.seed(level);
+		model.reset(level);
+		for (unsigned int i = 0; i < 600; ++i)
+			model.step();
+
+		Snapshot start;
+		std::vector<Snapshot> snapshots(depth);
+		model.saveSnapshot(start);
+		double rollbacks = measure(options.seconds, [&]() {
+			model.muteObservers(true);
+			model.loadSnapshot(start, false);
+			for (unsigned int i = 0; i < depth; ++i) {
+				model.saveSnapshot(snapshots[i]);
+				model.step();
+			}
+			model.muteObservers(false);
+		});
+		std::cout << "  level " << level << " (" << levels[level]->getName() << "): " << 1e6 / rollbacks
+			<< " us, " << 100 * 60 / rollbacks << "% of a 60 Hz frame" << std::endl;
+	}
+}
+
+// Measure ticking enemy clusters of increasing size, and finding their bounds as the model does every step
+void benchCluster(const Options& options) {
+	std::cout << "cluster: nanoseconds per cluster tick, and per finding the bounds of the cluster" << std::endl;
+	for (unsigned int count : { 50u, 200u, 800u, 3200u }) {
+		Md::EntityStore entities;
+		entities.reserve(Md::smallEnemy, count);
+		Md::EnemyCluster cluster(entities, std::make_shared<Time::ManualStopwatch>());
+		cluster.setSpeed(40, 0);
+		// A formation 20 enemies wide, packed tightly enough that it never reaches the bottom of the screen
+		for (unsigned int i = 0; i < count; ++i) {
+			double x = 100 + (i % 20) * 30, y = 20 + (i / 20) * 0.1;
+			Md::EntityHandle handle = entities.add(Md::smallEnemy, x, y, Md::entitySize(Md::smallEnemy, 1), 1);
+			cluster.enemyAdded(Md::smallEnemy, entities.getIndex(handle));
+		}
+
+		double ticks = measure(options.seconds, [&]() {
+			cluster.tick(1.0 / 120.0);
+		});
+		// Written to a volatile so that the queries can't be optimised away
+		volatile double bounds;
+		double queries = measure(options.seconds, [&]() {
+			bounds = cluster.leftMostPoint() + cluster.rightMostPoint() + cluster.lowestPoint();
+		});
+		std::cout << "  " << count << " enemies: " << 1e9 / ticks << " ns per tick, "
+			<< 1e9 / queries << " ns per bounds" << std::endl;
+	}
+}
+
+// Measure whole steps of the first level under both collision modes, with two players shooting, made denser by scattering
+// extra enemies over the top of the field and as many extra barriers over the middle
+// Every measurement starts from the same snapshot, and goes back to it every few seconds so that the level stays as dense
+void benchCollision(const Options& options, const std::vector<std::shared_ptr<Md::Level>>& levels) {
+	std::cout << "collision: microseconds per step on the first level with extra enemies and barriers, grid and brute force" << std::endl;
+	for (unsigned int extra : { 0u, 5u, 10u, 20u, 40u, 80u, 160u }) {
+		Md::Model model(1.0 / 120.0, 8, levels);
+		model.setPlayerCount(2);
+		model.registerInputSource(std::make_shared<Ctrl::ScriptedInput>(Ctrl::ScriptedInput::sweep(90)), 0);
+		model.registerInputSource(std::make_shared<Ctrl::ScriptedInput>(Ctrl::ScriptedInput::sweep(130)), 1);
+		model.seed(1);
+		model.reset(0);
+		RNG::RNG rng(1);
+		for (unsigned int i = 0; i < extra; ++i) {
+			model.addEntity(Md::smallEnemy, rng.realFromRange(40.0, 760.0), rng.realFromRange(20.0, 300.0));
+			model.addEntity(Md::barrier, rng.realFromRange(20.0, 780.0), rng.realFromRange(320.0, 560.0), 4);
+		}
+		for (unsigned int i = 0; i < 120; ++i)
+			model.step();
+
+		Snapshot start;
+		model.saveSnapshot(start);
+		double steps[2];
+		for (Md::CollisionMode mode : { Md::CollisionMode::uniformGrid, Md::CollisionMode::bruteForce }) {
+			model.setCollisionMode(mode);
+			model.loadSnapshot(start, false);
+			unsigned int taken = 0;
+			steps[mode == Md::CollisionMode::bruteForce] = measure(options.seconds, [&]() {
+				if (++taken == 600) {
+					model.loadSnapshot(start, false);
+					taken = 0;
+				}
+				model.step();
+			});
+		}
+		std::cout << "  " << extra << " extra enemies and barriers: " << 1e6 / steps[0] << " us grid, "
+			<< 1e6 / steps[1] << " us brute force" << std::endl;
+	}
+}
+
+// Measure taking the snapshot of every entity the observers read every step, and copying it as a MirrorObserver does
+void benchObserve(const Options& options) {
+	std::cout << "observe: nanoseconds per entity snapshot taken and copied" << std::endl;
+	for (unsigned int count : { 200u, 3200u, 51200u }) {
+		Md::EntityStore entities;
+		for (Md::EntityType type : { Md::smallEnemy, Md::playerBullet, Md::barrier })
+			entities.reserve(type, count / 3 + 1);
+		for (unsigned int i = 0; i < count; ++i) {
+			Md::EntityType type = i % 3 == 0 ? Md::smallEnemy : (i % 3 == 1 ? Md::playerBullet : Md::barrier);
+			entities.add(type, i % 800, i % 720, Md::entitySize(type, 1), 1);
+		}
+
+		std::vector<Md::EntityObserver> snapshot;
+		Md::MirrorObserver mirror;
+		double steps = measure(options.seconds, [&]() {
+			entities.observe(snapshot);
+			mirror.updateEntities(snapshot);
+		});
+		std::cout << "  " << count << " entities: " << 1e9 / (steps * count) << " ns per entity, "
+			<< 1e6 / steps << " us per step" << std::endl;
+	}
+}
+
+// Measure deciding which enemies fire each step, for increasing numbers of enemies
+// Every enemy fires once every 10 seconds on average, as in the model
+void benchShots(const Options& options) {
+	std::cout << "shots: nanoseconds per step deciding which enemies fire" << std::endl;
+	const double stepLength = 1.0 / 120.0;
+	for (unsigned int count : { 50u, 200u, 800u, 3200u }) {
+		auto clock = std::make_shared<Time::ManualStopwatch>();
+		RNG::RNG rng(1);
+		Md::ShotSchedule schedule(0.1, clock);
+		schedule.reserve(count);
+		for (unsigned int i = 0; i < count; ++i)
+			schedule.schedule(Md::EntityHandle(i, 0), Md::smallEnemy, rng);
+
+		unsigned long long steps = 0, shots = 0;
+		double scheduled = measure(options.seconds, [&]() {
+			clock->advance(stepLength);
+			++steps;
+			Md::ShotSchedule::Shot shot;
+			while (schedule.popDue(shot)) {
+				++shots;
+				schedule.scheduleAfter(shot, rng);
+			}
+		});
+
+		// Rolling for every enemy every step, which the schedule replaced
+		std::vector<double> rolls(count);
+		unsigned long long rolled = 0;
+		double rolling = measure(options.seconds, [&]() {
+			rng.reals(rolls.data(), count);
+			for (double roll : rolls)
+				if (roll < 0.1 * stepLength)
+					++rolled;
+		});
+		std::cout << "  " << count << " enemies: " << 1e9 / scheduled << " ns per step scheduled, "
+			<< 1e9 / rolling << " ns per step rolling, " << (double)shots / steps << " shots per step" << std::endl;
+	}
+}
+
+// Measure advancing a stopwatch and checking every timer based on it each step, for increasing numbers of timers
+// The timers have periods between a tenth of a second and ten seconds, so only a few of them are due each step
+void benchTimers(const Options& options) {
+	std::cout << "timers: nanoseconds per step advancing the stopwatch and checking every timer" << std::endl;
+	const double stepLength = 1.0 / 120.0;
+	for (unsigned int count : { 50u, 200u, 800u, 3200u }) {
+		auto clock = std::make_shared<Time::ManualStopwatch>();
+		RNG::RNG rng(1);
+		std::vector<Time::BinaryRepeatTimer> timers;
+		timers.reserve(count);
+		for (unsigned int i = 0; i < count; ++i)
+			timers.emplace_back(rng.realFromRange(0.1, 10.0), clock);
+
+		unsigned long long steps = 0, fired = 0;
+		double rate = measure(options.seconds, [&]() {
+			clock->advance(stepLength);
+			++steps;
+			for (auto& timer : timers)
+				if (timer())
+					++fired;
+		});
+		std::cout << "  " << count << " timers: " << 1e9 / rate << " ns per step, "
+			<< (double)fired / steps << " timers firing per step" << std::endl;
+	}
+}
+
+// Measure reading every clock the platform has, against reading the GlobalStopwatch's last sample
+void benchClocks(const Options& options) {
+	std::cout << "clocks: nanoseconds per reading, and the smallest step seen between readings" << std::endl;
+	// Written to a volatile so that the readings can't be optimised away
+	volatile long long sink;
+	for (const std::string& name : Time::clockNames()) {
+		std::shared_ptr<Time::Clock> clock;
+		try {
+			clock = Time::makeClock(name);
+		} catch (std::runtime_error& e) {
+			std::cout << "  " << name << ": not available, " << e.what() << std::endl;
+			continue;
+		}
+		double readings = measure(options.seconds, [&]() {
+			sink = clock->now().time_since_epoch().count();
+		});
+
+		auto step = std::chrono::nanoseconds::max();
+		TimePoint last = clock->now();
+		for (unsigned int i = 0; i < 1000000; ++i) {
+			TimePoint now = clock->now();
+			if (now != last)
+				step = std::min(step, std::chrono::duration_cast<std::chrono::nanoseconds>(now - last));
+			last = now;
+		}
+		std::cout << "  " << name << ": " << 1e9 / readings << " ns per reading, " << step.count() << " ns step" << std::endl;
+	}
+
+	auto stopwatch = Time::GlobalStopwatch::getInstance();
+	double samples = measure(options.seconds, [&]() {
+		stopwatch->sample();
+	});
+	double readings = measure(options.seconds, [&]() {
+		sink = stopwatch->now().time_since_epoch().count();
+	});
+	std::cout << "  GlobalStopwatch with the " << stopwatch->getClock()->getName() << " clock: " << 1e9 / samples << " ns per sample, "
+		<< 1e9 / readings << " ns per reading of the sample" << std::endl;
+}
+
+// Measure writing a step's worth of events into the model's ring and reading them through the cursors of two observers
+void benchEvents(const Options& options) {
+	std::cout << "events: nanoseconds per event written once and read by two observers" << std::endl;
+	Md::TextId text = Md::internText("SPEED UP!");
+	for (unsigned int perStep : { 4u, 64u, 512u }) {
+		Md::EventRing ring;
+		Md::EventRing::Cursor first = ring.end(), second = ring.end();
+		// Written to a volatile so that the reads can't be optimised away
+		volatile double sink;
+		double steps = measure(options.seconds, [&]() {
+			for (unsigned int i = 0; i < perStep; ++i)
+				ring.push(Md::Event(i % 8 ? Md::bulletHit : Md::pickup, i, i, i % 8 ? Md::noText : text));
+			while (const Md::Event* event = ring.next(first))
+				sink = event->getX();
+			while (const Md::Event* event = ring.next(second))
+				sink = event->getY();
+		});
+		std::cout << "  " << perStep << " events per step: " << 1e9 / (steps * perStep) << " ns per event, "
+			<< first.lost + second.lost << " lost" << std::endl;
+	}
+}
+
+// Measure how precisely a Pacer keeps deadlines 120 times per second, and how much processor time it takes doing so
+void benchPacing(const Options& options) {
+	std::cout << "pacing: waiting for deadlines 120 times per second" << std::endl;
+	const auto period = std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<double>(1.0 / 120.0));
+	auto stopwatch = Time::GlobalStopwatch::getInstance();
+	Time::Pacer pacer;
+	std::clock_t start = std::clock();
+	TimePoint deadline = stopwatch->read();
+	for (unsigned int i = 0; i < options.seconds * 120; ++i) {
+		deadline += period;
+		pacer.waitUntil(deadline);
+	}
+	double processorTime = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+	std::cout << "  " << pacer.getStats() << std::endl;
+	std::cout << "  " << 100 * processorTime / options.seconds << "% of a core, settled on a margin of "
+		<< pacer.getMargin() * 1e6 << " us" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	try {
+		Options options = parseOptions(argc, argv);
+		std::vector<std::shared_ptr<Md::Level>> levels = Md::LevelParser(options.levelDirectory).parseLevels();
+		if (levels.empty())
+			throw(std::runtime_error("No levels found in \"" + options.levelDirectory + "\"."));
+
+		bool ran = false;
+		if (options.benchmark.empty() || options.benchmark == "snapshot") {
+			benchSnapshot(options, levels);
+			ran = true;
+		}
+		if (options.benchmark.empty() || options.benchmark == "cluster") {
+			benchCluster(options);
+			ran = true;
+		}
+		if (options.benchmark.empty() || options.benchmark == "observe") {
+			benchObserve(options);
+			ran = true;
+		}
+		if (options.benchmark.empty() || options.benchmark == "shots") {
+			benchShots(options);
+			ran = true;
+		}
+		if (options.benchmark.empty() || options.benchmark == "timers") {
+			benchTimers(options);
+			ran = true;
+		}
+		if (options.benchmark.empty() || options.benchmark == "clocks") {
+			benchClocks(options);
+			ran = true;
+		}
+		if (options.benchmark.empty() || options.benchmark == "events") {
+			benchEvents(options);
+			ran = true;
+		}
+		if (options.benchmark.empty() || options.benchmark == "pacing") {
+			benchPacing(options);
+			ran = true;
+		}
+		if (options.benchmark.empty() || options.benchmark == "collision") {
+			benchCollision(options, levels);
+			ran = true;
+		}
+		if (options.benchmark.empty() || options.benchmark == "rollback") {
+			benchRollback(options, levels);
+			ran = true;
+		}
+		if (!ran)
+			throw(std::runtime_error("Unknown benchmark \"" + options.benchmark + "\"."));
+
+	} catch (std::exception& e) {
+		std::cout << "\nException encountered!" << std::endl;
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,176 @@
+// headless.cpp : Runs games of Space Invaders without a view, at full speed, from the command line.
+//
+
+#include "../SpaceInvaders/StdAfx.h"
+#include "../SpaceInvaders/model.h"
+#include "../SpaceInvaders/stats.h"
+#include "../SpaceInvaders/playback.h"
+
+using namespace SI;
+
+// The options the driver can be run with
+struct Options {
+	// The directory containing the level files
+	std::string levelDirectory = "Assets/levels/";
+
+	// The number of games to run
+	unsigned int games = 1;
+
+	// The length of a single simulation step in seconds
+	double stepLength = 1.0 / 120.0;
+
+	// The maximum number of simulated seconds a game may last
+	double maxSeconds = 600;
+
+	// The number of steps the scripted player moves in one direction before turning around
+	unsigned int sweepPeriod = 120;
+
+	// The seed of the first game, every next game uses the next seed
+	std::uint64_t seed = RNG::RNG::randomSeed();
+
+	// How the model finds colliding entities
+	Md::CollisionMode collisionMode = Md::CollisionMode::bruteForce;
+
+	// The file to record the game's input to, if any
+	std::string recordFile;
+
+	// The replay file to play back instead of running scripted games, if any
+	std::string replayFile;
+};
+
+void printUsage() {
+	std::cout << "Usage: SpaceInvadersHeadless [options]" << std::endl;
+	std::cout << "  --levels <dir>       directory containing the level files (default: Assets/levels/)" << std::endl;
+	std::cout << "  --games <n>          number of games to run (default: 1)" << std::endl;
+	std::cout << "  --step <seconds>     length of a simulation step (default: 1/120)" << std::endl;
+	std::cout << "  --max-seconds <s>    simulated time after which a game is cut off (default: 600)" << std::endl;
+	std::cout << "  --sweep <steps>      steps the scripted player moves each way (default: 120)" << std::endl;
+	std::cout << "  --seed <n>           seed of the first game (default: random)" << std::endl;
+	std::cout << "  --collision <mode>   grid or brute, how colliding entities are found (default: brute)" << std::endl;
+	std::cout << "  --record <file>      record the input of the game to a replay file, only with a single game" << std::endl;
+	std::cout << "  --replay <file>      play back a replay file instead of running scripted games" << std::endl;
+}
+
+Options parseOptions(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--help") {
+			printUsage();
+			std::exit(0);
+		}
+		if (i + 1 == argc)
+			throw(std::runtime_error("Missing value for option \"" + arg + "\"."));
+		std::string value = argv[++i];
+
+		if (arg == "--levels")
+			options.levelDirectory = value;
+		else if (arg == "--games")
+			options.games = std::stoul(value);
+		else if (arg == "--step")
+			options.stepLength = std::stod(value);
+		else if (arg == "--max-seconds")
+			options.maxSeconds = std::stod(value);
+		else if (arg == "--sweep")
+			options.sweepPeriod = std::stoul(value);
+		else if (arg == "--seed")
+			options.seed = std::stoull(value);
+		else if (arg == "--collision") {
+			if (value == "grid")
+				options.collisionMode = Md::CollisionMode::uniformGrid;
+			else if (value == "brute")
+				options.collisionMode = Md::CollisionMode::bruteForce;
+			else
+				throw(std::runtime_error("Unrecognised collision mode \"" + value + "\", expected grid or brute."));
+		}
+		else if (arg == "--record")
+			options.recordFile = value;
+		else if (arg == "--replay")
+			options.replayFile = value;
+		else
+			throw(std::runtime_error("Unrecognised option \"" + arg + "\"."));
+	}
+	if (!options.recordFile.empty() && options.games != 1)
+		throw(std::runtime_error("Only a single game can be recorded."));
+	return options;
+}
+
+// Print how a game went
+void printResult(const std::string& label, const Md::StatsObserver& stats, unsigned long long steps, double stepLength, double wallSeconds) {
+	std::string result = stats.getState() == Md::ModelState::victory ? "victory"
+		: stats.getState() == Md::ModelState::gameOver ? "game over" : "cut off";
+
+	std::cout << label << ": " << result
+		<< ", levels completed: " << stats.getLevelsCompleted()
+		<< ", last level: " << stats.getLevelName()
+		<< ", simulated seconds: " << steps * stepLength
+		<< ", enemies destroyed: " << stats.getEnemiesDestroyed()
+		<< ", lives: " << stats.getLives()
+		<< ", steps per second: " << (wallSeconds > 0 ? steps / wallSeconds : 0) << std::endl;
+}
+
+// Play back a replay file as fast as possible
+void playReplay(const Options& options) {
+	std::ifstream file(options.replayFile, std::ios::binary);
+	if (!file)
+		throw(std::runtime_error("Failed to open replay file: " + options.replayFile));
+	auto replay = std::make_shared<Ctrl::Replay>(Ctrl::Replay::load(file));
+
+	Md::Model model(replay->getStepLength(), 8, options.levelDirectory);
+	model.setCollisionMode(options.collisionMode);
+	auto stats = std::make_shared<Md::StatsObserver>();
+	model.registerObserver(stats);
+	Md::ReplayPlayer player(model, replay);
+
+	auto start = std::chrono::steady_clock::now();
+	while (!player.isFinished())
+		player.step();
+	double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printResult("Replay (seed " + std::to_string(replay->getSeed()) + ")", *stats, player.getStep(), replay->getStepLength(), wallSeconds);
+}
+
+int main(int argc, char* argv[])
+{
+	try {
+		Options options = parseOptions(argc, argv);
+		if (!options.replayFile.empty()) {
+			playReplay(options);
+			return 0;
+		}
+		unsigned long long maxSteps = (unsigned long long)(options.maxSeconds / options.stepLength);
+
+		for (unsigned int game = 0; game < options.games; ++game) {
+			Md::Model model(options.stepLength, 8, options.levelDirectory);
+			model.setCollisionMode(options.collisionMode);
+
+			auto stats = std::make_shared<Md::StatsObserver>();
+			model.registerObserver(stats);
+			auto input = std::make_shared<Ctrl::ScriptedInput>(Ctrl::ScriptedInput::sweep(options.sweepPeriod));
+			if (options.recordFile.empty())
+				model.registerInputSource(input);
+			else
+				model.registerInputSource(std::make_shared<Ctrl::RecordingInput>(input,
+					std::make_shared<Ctrl::Replay>(options.seed + game, 0, options.stepLength), options.recordFile));
+			model.seed(options.seed + game);
+			model.reset();
+
+			auto start = std::chrono::steady_clock::now();
+			unsigned long long steps = 0;
+			while (!stats->isFinished() && steps < maxSteps) {
+				model.step();
+				++steps;
+			}
+			double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			printResult("Game " + std::to_string(game) + " (seed " + std::to_string(options.seed + game) + ")", *stats, steps, options.stepLength, wallSeconds);
+		}
+
+	} catch (std::exception& e) {
+		std::cout << "\nException encountered!" << std::endl;
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
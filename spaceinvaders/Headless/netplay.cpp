@@ -0,0 +1,218 @@
+// netplay.cpp : Plays one end of a two player netplay session without a view, from the command line.
+// Run two of them to test netplay on a single machine, for example with 50 ms of latency and 5% packet loss each way:
+//   SpaceInvadersNetplay --player 1 --port 7001 --peer-port 7002 --latency 50 --loss 5
+//   SpaceInvadersNetplay --player 2 --port 7002 --peer-port 7001 --latency 50 --loss 5
+// Both ends print a checksum of the final state, which should be the same.
+//
+
+#include "../SpaceInvaders/StdAfx.h"
+#include "../SpaceInvaders/netplay.h"
+#include "../SpaceInvaders/stats.h"
+
+using namespace SI;
+
+// The options the driver can be run with
+struct Options {
+	// The directory containing the level files
+	std::string levelDirectory = "Assets/levels/";
+
+	// The number of the local player, 1 hosts
+	unsigned int player = 1;
+
+	// The local port, and the host and port of the peer
+	unsigned short port = 7001;
+	std::string peerHost = "127.0.0.1";
+	unsigned short peerPort = 7002;
+
+	// The number of steps to play
+	unsigned long long steps = 1200;
+
+	// The length of a single simulation step in seconds
+	double stepLength = 1.0 / 120.0;
+
+	// The seed of the game, only used by the host
+	std::uint64_t seed = RNG::RNG::randomSeed();
+
+	// The level to start at, only used by the host
+	unsigned int startLevel = 0;
+
+	// The number of steps the scripted player moves in one direction before turning around
+	unsigned int sweepPeriod = 0;
+
+	// The latency and jitter added to every packet sent in milliseconds, and the percentage of packets dropped
+	double latency = 0, jitter = 0, loss = 0;
+
+	// The most steps a rollback may go back, and the number of steps local input is held back
+	unsigned int maxRollback = 8;
+	unsigned int inputDelay = 2;
+
+	// The number of seconds to wait for the peer before giving up
+	double timeout = 10;
+};
+
+void printUsage() {
+	std::cout << "Usage: SpaceInvadersNetplay [options]" << std::endl;
+	std::cout << "  --levels <dir>       directory containing the level files (default: Assets/levels/)" << std::endl;
+	std::cout << "  --player <1|2>       the local player, player 1 hosts (default: 1)" << std::endl;
+	std::cout << "  --port <port>        local UDP port (default: 7001)" << std::endl;
+	std::cout << "  --peer-host <host>   host of the peer (default: 127.0.0.1)" << std::endl;
+	std::cout << "  --peer-port <port>   UDP port of the peer (default: 7002)" << std::endl;
+	std::cout << "  --steps <n>          number of steps to play (default: 1200)" << std::endl;
+	std::cout << "  --step <seconds>     length of a simulation step, the same on both ends (default: 1/120)" << std::endl;
+	std::cout << "  --seed <n>           seed of the game, host only (default: random)" << std::endl;
+	std::cout << "  --level <n>          level to start at, host only (default: 0)" << std::endl;
+	std::cout << "  --sweep <steps>      steps the scripted player moves each way (default: 90 for player 1, 130 for player 2)" << std::endl;
+	std::cout << "  --latency <ms>       delay added to every packet sent (default: 0)" << std::endl;
+	std::cout << "  --jitter <ms>        random extra delay of up to this much (default: 0)" << std::endl;
+	std::cout << "  --loss <percent>     percentage of packets sent that are dropped (default: 0)" << std::endl;
+	std::cout << "  --rollback <steps>   most steps a rollback may go back (default: 8)" << std::endl;
+	std::cout << "  --delay <steps>      steps local input is held back (default: 2)" << std::endl;
+	std::cout << "  --timeout <s>        seconds to wait for the peer before giving up (default: 10)" << std::endl;
+}
+
+Options parseOptions(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--help") {
+			printUsage();
+			std::exit(0);
+		}
+		if (i + 1 == argc)
+			throw(std::runtime_error("Missing value for option \"" + arg + "\"."));
+		std::string value = argv[++i];
+
+		if (arg == "--levels")
+			options.levelDirectory = value;
+		else if (arg == "--player")
+			options.player = std::stoul(value);
+		else if (arg == "--port")
+			options.port = (unsigned short)std::stoul(value);
+		else if (arg == "--peer-host")
+			options.peerHost = value;
+		else if (arg == "--peer-port")
+			options.peerPort = (unsigned short)std::stoul(value);
+		else if (arg == "--steps")
+			options.steps = std::stoull(value);
+		else if (arg == "--step")
+			options.stepLength = std::stod(value);
+		else if (arg == "--seed")
+			options.seed = std::stoull(value);
+		else if (arg == "--level")
+			options.startLevel = std::stoul(value);
+		else if (arg == "--sweep")
+			options.sweepPeriod = std::stoul(value);
+		else if (arg == "--latency")
+			options.latency = std::stod(value);
+		else if (arg == "--jitter")
+			options.jitter = std::stod(value);
+		else if (arg == "--loss")
+			options.loss = std::stod(value);
+		else if (arg == "--rollback")
+			options.maxRollback = std::stoul(value);
+		else if (arg == "--delay")
+			options.inputDelay = std::stoul(value);
+		else if (arg == "--timeout")
+			options.timeout = std::stod(value);
+		else
+			throw(std::runtime_error("Unrecognised option \"" + arg + "\"."));
+	}
+	if (options.player != 1 && options.player != 2)
+		throw(std::runtime_error("The player has to be 1 or 2."));
+	if (!options.sweepPeriod)
+		options.sweepPeriod = options.player == 1 ? 90 : 130;
+	return options;
+}
+
+// Wait a moment before polling again, then read the time the model and the link go by
+void nap(std::chrono::milliseconds wait = std::chrono::milliseconds(1)) {
+	std::this_thread::sleep_for(wait);
+	Time::GlobalStopwatch::getInstance()->sample();
+}
+
+int main(int argc, char* argv[])
+{
+	try {
+		Options options = parseOptions(argc, argv);
+
+		Md::Model model(options.stepLength, 8, options.levelDirectory);
+		auto stats = std::make_shared<Md::StatsObserver>();
+		model.registerObserver(stats);
+
+		std::shared_ptr<Ctrl::Link> link = std::make_shared<Ctrl::UdpLink>(options.port, options.peerHost, options.peerPort);
+		if (options.latency > 0 || options.jitter > 0 || options.loss > 0)
+			link = std::make_shared<Ctrl::LossyLink>(link, options.latency / 1000, options.jitter / 1000, options.loss / 100);
+
+		auto input = std::make_shared<Ctrl::ScriptedInput>(Ctrl::ScriptedInput::sweep(options.sweepPeriod));
+		Md::RollbackSession session(model, input, link, options.player - 1, options.seed, options.startLevel,
+			options.maxRollback, options.inputDelay);
+
+		std::cout << "Player " << options.player << " waiting for the peer on port " << options.port << "..." << std::endl;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(options.timeout);
+		while (!session.synchronize()) {
+			if (std::chrono::steady_clock::now() > deadline)
+				throw(std::runtime_error("The peer didn't answer."));
+			nap(std::chrono::milliseconds(20));
+		}
+		std::cout << "Synchronized, playing " << options.steps << " steps." << std::endl;
+
+		// Play in real time, as the game would
+		auto start = std::chrono::steady_clock::now();
+		model.dueSteps();
+		while (session.getSteps() < options.steps) {
+			unsigned long long before = session.getConfirmedSteps();
+			session.poll();
+			for (unsigned int due = model.dueSteps(); due && session.getSteps() < options.steps; --due)
+				session.advance();
+			if (session.getConfirmedSteps() != before)
+				deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(options.timeout);
+			else if (std::chrono::steady_clock::now() > deadline)
+				throw(std::runtime_error("Lost the peer."));
+			nap();
+		}
+
+		// Wait for the peer's last inputs, and keep sending ours a while longer in case the peer is still waiting for them
+		while (session.getConfirmedSteps() < options.steps) {
+			if (std::chrono::steady_clock::now() > deadline)
+				throw(std::runtime_error("Lost the peer."));
+			session.poll();
+			session.sendInputs();
+			nap(std::chrono::milliseconds(5));
+		}
+		double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		auto linger = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+		while (std::chrono::steady_clock::now() < linger) {
+			session.poll();
+			session.sendInputs();
+			nap(std::chrono::milliseconds(5));
+		}
+
+		Snapshot snapshot;
+		model.saveSnapshot(snapshot);
+		const Md::NetplayStats& netStats = session.getStats();
+		std::cout << "Played " << session.getSteps() << " steps in " << wallSeconds << " seconds" << std::endl;
+		std::cout << "  rollbacks: " << netStats.rollbacks
+			<< ", steps resimulated: " << netStats.resimulatedSteps
+			<< ", deepest rollback: " << netStats.maxRollbackDepth
+			<< ", stalls: " << netStats.stalls << std::endl;
+		std::cout << "  packets sent: " << netStats.packetsSent
+			<< ", bytes sent: " << netStats.bytesSent
+			<< " (" << (double)netStats.bytesSent / session.getSteps() << " per step)"
+			<< ", packets received: " << netStats.packetsReceived
+			<< ", bad packets: " << netStats.badPackets << std::endl;
+		std::cout << "  checksums compared: " << netStats.checks << ", desyncs: " << netStats.desyncs << std::endl;
+		std::cout << "  level: " << stats->getLevelName() << ", enemies destroyed: " << stats->getEnemiesDestroyed()
+			<< ", lives: " << stats->getLives() << std::endl;
+		std::cout << "Final checksum: " << std::hex << snapshot.checksum() << std::dec << std::endl;
+
+		if (netStats.desyncs)
+			return 2;
+
+	} catch (std::exception& e) {
+		std::cout << "\nException encountered!" << std::endl;
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
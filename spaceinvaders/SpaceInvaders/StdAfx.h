@@ -11,6 +11,8 @@
 //#include <tchar.h>
 
 #include <vector>
+#include <array>
+#include <cstdint>
 #include <queue>
 #include <string>
 #include <bitset>
@@ -21,9 +23,9 @@
 #include <chrono>
 #include <thread>
 #include <memory>
+#include <type_traits>
 #include <numeric>
+#include <cmath>
+#include <cstring>
 #include <exception>
 
-#include <SFML/Graphics.hpp>
-#include <SFML/Audio.hpp>
-
@@ -0,0 +1,49 @@
+#include "StdAfx.h"
+#include "batch.h"
+
+namespace SI {
+	namespace Vw {
+
+	// SpriteBatch
+
+		SpriteBatch::SpriteBatch(const sf::Texture* texture) :
+			texture(texture),
+			vertices(sf::Quads),
+			quads(0)
+		{}
+
+		void SpriteBatch::addSprite(const sf::Sprite& sprite, float x, float y) {
+			if (sprite.getTexture() != texture)
+				throw(std::runtime_error("Attempted to batch a sprite of a different texture."));
+			const sf::IntRect& rect = sprite.getTextureRect();
+			float width = rect.width * sprite.getScale().x, height = rect.height * sprite.getScale().y;
+			float left = (float)rect.left, top = (float)rect.top, right = (float)(rect.left + rect.width), bottom = (float)(rect.top + rect.height);
+			sf::Color color = sprite.getColor();
+			vertices.append(sf::Vertex(sf::Vector2f(x, y), color, sf::Vector2f(left, top)));
+			vertices.append(sf::Vertex(sf::Vector2f(x + width, y), color, sf::Vector2f(right, top)));
+			vertices.append(sf::Vertex(sf::Vector2f(x + width, y + height), color, sf::Vector2f(right, bottom)));
+			vertices.append(sf::Vertex(sf::Vector2f(x, y + height), color, sf::Vector2f(left, bottom)));
+			++quads;
+		}
+
+		void SpriteBatch::addRectangle(float x, float y, float width, float height, sf::Color color) {
+			vertices.append(sf::Vertex(sf::Vector2f(x, y), color));
+			vertices.append(sf::Vertex(sf::Vector2f(x + width, y), color));
+			vertices.append(sf::Vertex(sf::Vector2f(x + width, y + height), color));
+			vertices.append(sf::Vertex(sf::Vector2f(x, y + height), color));
+			++quads;
+		}
+
+		void SpriteBatch::flush(sf::RenderTarget& target) {
+			if (quads)
+				target.draw(vertices, sf::RenderStates(texture));
+			vertices.clear();
+			quads = 0;
+		}
+
+		unsigned int SpriteBatch::size() const {
+			return quads;
+		}
+
+	}
+}
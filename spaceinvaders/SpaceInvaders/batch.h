@@ -0,0 +1,40 @@
+#pragma once
+#include "StdAfx.h"
+#include <SFML/Graphics.hpp>
+
+namespace SI {
+	namespace Vw {
+
+		// Collects quads into a single vertex array, to draw any number of them in a single draw call
+		// Every quad in a batch is drawn with the same texture, sprites of different textures need batches of their own
+		// The vertex array keeps its storage when flushed, so that batching doesn't allocate from frame to frame
+		class SpriteBatch {
+		private:
+			// The texture the quads are drawn with, or nullptr to draw plain colored quads
+			const sf::Texture* texture;
+
+			// The four corners of every quad added since the last flush
+			sf::VertexArray vertices;
+
+			// The number of quads added since the last flush
+			unsigned int quads;
+
+		public:
+			SpriteBatch(const sf::Texture* texture = nullptr);
+
+			// Add a sprite with its top-left corner at (x, y), cut out of the texture and scaled as the sprite is
+			// Throws if the sprite is of a different texture than the batch
+			void addSprite(const sf::Sprite& sprite, float x, float y);
+
+			// Add a plain rectangle with its top-left corner at (x, y)
+			void addRectangle(float x, float y, float width, float height, sf::Color color);
+
+			// Draw every quad added since the last flush to 'target' in a single draw call, and empty the batch
+			void flush(sf::RenderTarget& target);
+
+			// Get the number of quads added since the last flush
+			unsigned int size() const;
+		};
+
+	}
+}
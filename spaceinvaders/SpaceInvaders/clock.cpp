@@ -0,0 +1,128 @@
+#include "StdAfx.h"
+#include "clock.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define SI_HAS_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#define SI_HAS_TSC
+#endif
+
+namespace SI
+{
+	namespace Time {
+
+		// Helper functions
+
+#ifdef SI_HAS_TSC
+		// Whether or not the processor's time stamp counter ticks at a constant rate, even as the processor changes speed or sleeps
+		static bool invariantTsc() {
+			unsigned int regs[4] = {};
+#ifdef _MSC_VER
+			__cpuid((int*)regs, 0x80000000);
+			if (regs[0] < 0x80000007)
+				return false;
+			__cpuid((int*)regs, 0x80000007);
+#else
+			if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+				return false;
+			__get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+			return (regs[3] >> 8) & 1;
+		}
+#endif
+
+	// SystemClock : public Clock
+
+		TimePoint SystemClock::now() const {
+			return std::chrono::high_resolution_clock::now();
+		}
+
+		std::string SystemClock::getName() const {
+			return "system";
+		}
+
+	// CoarseClock : public Clock
+
+		CoarseClock::CoarseClock() : start(std::chrono::high_resolution_clock::now()), startReading(read()) {}
+
+		std::chrono::nanoseconds CoarseClock::read() {
+#ifdef _WIN32
+			return std::chrono::milliseconds(GetTickCount64());
+#elif defined(CLOCK_MONOTONIC_COARSE)
+			timespec ts;
+			clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+			return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+#else
+			throw(std::runtime_error("This platform has no coarse clock."));
+#endif
+		}
+
+		TimePoint CoarseClock::now() const {
+			return start + (read() - startReading);
+		}
+
+		std::string CoarseClock::getName() const {
+			return "coarse";
+		}
+
+	// TscClock : public Clock
+
+		TscClock::TscClock(double calibration) {
+#ifdef SI_HAS_TSC
+			if (!invariantTsc())
+				throw(std::runtime_error("This processor's time stamp counter doesn't tick at a constant rate."));
+#endif
+			start = std::chrono::high_resolution_clock::now();
+			startTicks = read();
+			std::this_thread::sleep_for(std::chrono::duration<double>(calibration));
+			TimePoint end = std::chrono::high_resolution_clock::now();
+			std::uint64_t endTicks = read();
+			if (endTicks <= startTicks)
+				throw(std::runtime_error("Failed to calibrate the time stamp counter."));
+			nanosPerTick = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (endTicks - startTicks);
+		}
+
+		std::uint64_t TscClock::read() {
+#ifdef SI_HAS_TSC
+			return __rdtsc();
+#else
+			throw(std::runtime_error("This processor has no time stamp counter."));
+#endif
+		}
+
+		TimePoint TscClock::now() const {
+			return start + std::chrono::nanoseconds((long long)((read() - startTicks) * nanosPerTick));
+		}
+
+		std::string TscClock::getName() const {
+			return "tsc";
+		}
+
+	// Clock factory
+
+		std::vector<std::string> clockNames() {
+			return { "system", "coarse", "tsc" };
+		}
+
+		std::shared_ptr<Clock> makeClock(const std::string& name) {
+			if (name == "system")
+				return std::make_shared<SystemClock>();
+			if (name == "coarse")
+				return std::make_shared<CoarseClock>();
+			if (name == "tsc")
+				return std::make_shared<TscClock>();
+			throw(std::runtime_error("Unknown clock \"" + name + "\"."));
+		}
+
+	}
+}
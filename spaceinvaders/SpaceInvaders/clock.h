@@ -0,0 +1,76 @@
+#pragma once
+
+#include "StdAfx.h"
+#include "wheel.h"
+
+namespace SI
+{
+	namespace Time {
+
+		// A source of the current time in real time, which the GlobalStopwatch reads once every sample
+		// Different clocks trade precision for the cost of reading them
+		class Clock {
+		public:
+			virtual ~Clock() {}
+
+			// Read the current time, which never moves backwards
+			virtual TimePoint now() const = 0;
+
+			// Get the name the clock is chosen by
+			virtual std::string getName() const = 0;
+		};
+
+		// The standard library's high resolution clock, precise to the nanosecond but the most expensive to read
+		class SystemClock : public Clock {
+		public:
+			TimePoint now() const;
+			std::string getName() const;
+		};
+
+		// The operating system's coarse monotonic clock, which is read without asking the kernel
+		// Only as precise as the scheduler's tick, a few milliseconds, which is plenty for timers of a tenth of a second
+		// Throws if the platform has no such clock
+		class CoarseClock : public Clock {
+		private:
+			// The system clock's time and the coarse clock's reading, at construction
+			TimePoint start;
+			std::chrono::nanoseconds startReading;
+
+			// Read the coarse clock, counting from some moment of the platform's choosing
+			static std::chrono::nanoseconds read();
+
+		public:
+			CoarseClock();
+			TimePoint now() const;
+			std::string getName() const;
+		};
+
+		// The processor's time stamp counter, the cheapest clock to read, calibrated against the system clock
+		// Throws if the processor has no time stamp counter which ticks at a constant rate through power states
+		class TscClock : public Clock {
+		private:
+			// The system clock's time and the counter's reading, at the start of calibration
+			TimePoint start;
+			std::uint64_t startTicks;
+
+			// The number of nanoseconds per tick of the counter
+			double nanosPerTick;
+
+			// Read the counter
+			static std::uint64_t read();
+
+		public:
+			// Calibrate the counter against the system clock, which takes 'calibration' seconds
+			TscClock(double calibration = 0.05);
+			TimePoint now() const;
+			std::string getName() const;
+		};
+
+		// Get the names of every clock, whether or not the platform has it: "system", "coarse" and "tsc"
+		std::vector<std::string> clockNames();
+
+		// Make the clock with the given name, throws if there is no such clock or the platform doesn't have it
+		std::shared_ptr<Clock> makeClock(const std::string& name);
+
+	}
+}
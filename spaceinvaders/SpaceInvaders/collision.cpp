@@ -0,0 +1,102 @@
+#include "StdAfx.h"
+#include "collision.h"
+
+namespace SI {
+	namespace Md {
+
+		// Helper functions
+
+		bool hit(double x1, double y1, float size1, double x2, double y2, float size2) {
+			double dx = x1 - x2;
+			double dy = y1 - y2;
+			double reach = (double)size1 + size2;
+			return dx*dx + dy*dy <= reach*reach;
+		}
+
+		bool sweep(double x0, double y0, double x1, double y1, float size1, double x2, double y2, float size2, double& t) {
+			// Solve |m + t*d| = reach for the smallest t, with m the offset between the circles at the start
+			double mx = x0 - x2, my = y0 - y2;
+			double dx = x1 - x0, dy = y1 - y0;
+			double reach = (double)size1 + size2;
+
+			double c = mx*mx + my*my - reach*reach;
+			if (c <= 0) {	// Already touching at the start
+				t = 0;
+				return true;
+			}
+			double a = dx*dx + dy*dy;
+			double b = mx*dx + my*dy;
+			if (a == 0 || b >= 0)	// Not moving, or moving away
+				return false;
+
+			double disc = b*b - a*c;
+			if (disc < 0)
+				return false;
+
+			t = (-b - std::sqrt(disc)) / a;
+			return t <= 1;
+		}
+
+		// Collision
+
+		Collision::Collision(double t, EntityType type, unsigned int index) :
+			t(t), type(type), index(index) {}
+
+		// CollisionGrid
+
+		CollisionGrid::CollisionGrid(double width, double height, double cellSize) :
+			cellSize(cellSize),
+			columns((unsigned int)std::ceil(width / cellSize)),
+			rows((unsigned int)std::ceil(height / cellSize)),
+			maxSize(0)
+		{
+			for (auto& c : cells)
+				c.resize(columns * rows);
+		}
+
+		unsigned int CollisionGrid::column(double x) const {
+			if (x < 0)
+				return 0;
+			return std::min((unsigned int)(x / cellSize), columns - 1);
+		}
+
+		unsigned int CollisionGrid::row(double y) const {
+			if (y < 0)
+				return 0;
+			return std::min((unsigned int)(y / cellSize), rows - 1);
+		}
+
+		void CollisionGrid::clear() {
+			for (auto& c : cells)
+				for (auto& cell : c)
+					cell.clear();
+			maxSize = 0;
+		}
+
+		void CollisionGrid::insert(EntityType type, const EntityArray& array) {
+			for (auto& cell : cells[type])
+				cell.clear();
+
+			for (unsigned int i = 0; i < array.count(); ++i) {
+				unsigned int c = row(array.worldY(i)) * columns + column(array.worldX(i));
+				cells[type][c].push_back(i);
+				maxSize = std::max(maxSize, array.size[i]);
+			}
+		}
+
+		void CollisionGrid::query(EntityType type, double x, double y, float size, std::vector<unsigned int>& out) const {
+			out.clear();
+			double reach = (double)size + maxSize;
+			unsigned int c0 = column(x - reach), c1 = column(x + reach);
+			unsigned int r0 = row(y - reach), r1 = row(y + reach);
+
+			for (unsigned int r = r0; r <= r1; ++r)
+				for (unsigned int c = c0; c <= c1; ++c) {
+					const std::vector<unsigned int>& cell = cells[type][r * columns + c];
+					out.insert(out.end(), cell.begin(), cell.end());
+				}
+			std::sort(out.begin(), out.end());
+		}
+
+	}
+}
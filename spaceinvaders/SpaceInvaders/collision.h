@@ -0,0 +1,70 @@
+#pragma once
+
+#include "StdAfx.h"
+#include "store.h"
+
+namespace SI {
+	namespace Md {
+
+		// The ways in which the model can find colliding pairs of entities
+		enum class CollisionMode {
+			// Test every pair of entities
+			bruteForce,
+			// Only test pairs of entities that share a cell of a CollisionGrid
+			uniformGrid
+		};
+
+		// Check whether or not two circles touch
+		bool hit(double x1, double y1, float size1, double x2, double y2, float size2);
+
+		// Check whether or not a circle moving from (x0, y0) to (x1, y1) touches a stationary circle at (x2, y2)
+		// If so, 't' is set to the earliest fraction of the movement at which they touch, between 0 and 1
+		bool sweep(double x0, double y0, double x1, double y1, float size1, double x2, double y2, float size2, double& t);
+
+		// A collision found along a moving entity's path, with another entity of the given type and index
+		struct Collision {
+			// The fraction of the movement at which the collision happens
+			double t;
+
+			EntityType type;
+			unsigned int index;
+
+			Collision(double t, EntityType type, unsigned int index);
+		};
+
+		// A uniform grid over the playing field, bucketing entities by the cell their center lies in
+		// Used as a broadphase, so that 'hit' only has to be checked for entities close to each other
+		class CollisionGrid {
+		private:
+			// The size of a single square cell
+			double cellSize;
+
+			// The number of columns and rows of cells
+			unsigned int columns, rows;
+
+			// The largest size of any inserted entity, used to widen queries
+			float maxSize;
+
+			// For every EntityType, the indices of the entities within each cell
+			std::array<std::vector<std::vector<unsigned int>>, entityTypeCount> cells;
+
+			// Get the column or row containing the given coordinate, clamped to the grid
+			unsigned int column(double x) const;
+			unsigned int row(double y) const;
+
+		public:
+			CollisionGrid(double width, double height, double cellSize);
+
+			// Remove every entity from the grid
+			void clear();
+
+			// Insert every entity of the given EntityArray, overwriting any previously inserted entities of that type
+			void insert(EntityType type, const EntityArray& array);
+
+			// Find the indices of all entities of the given type that might touch a circle at (x, y) with the given size
+			// The indices are written to 'out' in ascending order, the same order a brute force search would find them in
+			void query(EntityType type, double x, double y, float size, std::vector<unsigned int>& out) const;
+		};
+
+	}
+}
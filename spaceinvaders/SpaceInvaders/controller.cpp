@@ -35,17 +35,13 @@ namespace SI {
 			}
 		}
 
-		std::vector<Input> Controller::getInput() {
-			
-			std::vector<Input> out;
-
-			for (unsigned int i = 0; i < MAX_INPUTNUM + 1; ++i) {
-				if (recordedInput[i]) {
-					out.push_back(Input(i));
-				}
-			}
+		TimePoint Controller::getNextUpdate() const {
+			return updateTimer.getDeadline();
+		}
+
+		InputState Controller::getInput() {
 			read = true;
-			return out;
+			return recordedInput;
 		}
 	
 	}
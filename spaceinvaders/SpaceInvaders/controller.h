@@ -1,21 +1,18 @@
 #pragma once
 #include "StdAfx.h"
+#include <SFML/Window.hpp>
 #include "time.h"
+#include "input.h"
 
 #define isPressed(key) sf::Keyboard::isKeyPressed(key)
 
 namespace SI {
 	namespace Ctrl {
 
-		// An enum representing user input
-		enum Input {
-			left, right, shoot, pause, MAX_INPUTNUM = pause
-		};
-		
-		// A class representing a keyboard-based controller
-		class Controller {
+		// An InputSource reading the keyboard
+		class Controller : public InputSource {
 		private:
-			std::bitset<MAX_INPUTNUM + 1> recordedInput;
+			InputState recordedInput;
 			Time::BinaryRepeatTimer updateTimer;
 			bool read;
 
@@ -25,9 +22,12 @@ namespace SI {
 			// Check which keys are pressed
 			void update();
 
-			// Returns the registered input as a vector of Input
-			// Will return the exact same vector until update() is called again
-			std::vector<Input> getInput();
+			// Get the moment the keys are due to be checked again, by the global stopwatch
+			TimePoint getNextUpdate() const;
+
+			// Returns the registered input
+			// Will return the exact same input until update() is called again
+			virtual InputState getInput();
 
 		};
 
@@ -18,6 +18,14 @@ namespace SI {
 			return nanoToSeconds(stopwatch->now() - start);
 		}
 
+		void Counter::save(Snapshot& out) const {
+			out.write(start);
+		}
+
+		void Counter::load(Snapshot::Reader& in) {
+			in.read(start);
+		}
+
 		// PeriodCounter
 
 		PeriodCounter::PeriodCounter(double period, std::shared_ptr<Stopwatch> sw) : 
@@ -20,6 +20,12 @@ namespace SI {
 			// Get the number of seconds that have passed
 			double getSeconds() const;
 
+			// Write the state to a snapshot
+			void save(Snapshot& out) const;
+
+			// Read the state back from a snapshot
+			void load(Snapshot::Reader& in);
+
 		};
 
 		// A class that counts how many times a certain period has passed since its creation, useful for timed animations
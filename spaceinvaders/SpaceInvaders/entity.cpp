@@ -5,87 +5,13 @@
 namespace SI {
 	namespace Md {
 
-		// Entity
-		
-		Entity::Entity(EntityType type, double xpos, double ypos, float size, int health) :
-			type(type), xpos(xpos), ypos(ypos), size(size), health(health) {
-		}
-
-		void Entity::registerModel(Model * model){
-			this->model = model;
-		}
-
-		void Entity::registerObserver(std::shared_ptr<EntityObserver>& observer){
-			observers.push_back(observer);
-			observer->updateType(type);
-			updatePosition();
-			updateHealth();
-		}
-
-		const std::vector<std::shared_ptr<EntityObserver>>& Entity::getObservers() const {
-			return observers;
-		}
-
-		double Entity::getX() const {
-			return xpos;
-		}
-
-		double Entity::getY() const {
-			return ypos;
-		}
-
-		void Entity::setX(double xpos) {
-			this->xpos = xpos;
-		}
-
-		void Entity::setY(double ypos) {
-			this->ypos = ypos;
-		}
-
-		float Entity::getSize() const {
-			return size;
-		}
-
-		int Entity::getHealth() const {
-			return health;
-		}
-
-		void Entity::setHealth(int health){
-			this->health = health;
-		}
-
-		void Entity::updatePosition(){
-			if (observers.empty())
-				throw(std::runtime_error("Entity does not have any associated observers!"));
-			for( auto& observer : observers)
-				observer->updatePosition(xpos, ypos);
-		}
-
-		void Entity::updateHealth(){
-			if (observers.empty())
-				throw(std::runtime_error("Entity does not have any associated observers!"));
-			for (auto& observer : observers)
-				observer->updateHealth(health);
-		}
-
-		bool Entity::hit(const std::shared_ptr<Entity> e) const {
-			double D = sqrt(pow((xpos - e->xpos), 2) + pow((ypos - e->ypos), 2));
-			double d = D - (size + e->size);
-			if (d > 0)
-				return false;
-			return true;
-		}
+		// Player
 
-		bool Entity::isDead() const {
-			return health <= 0;
-		}
-		
-		// Player : Entity
-
-		Player::Player(double x, double y, std::shared_ptr<Time::Stopwatch> stopwatch) :
-			Entity( EntityType::player, x, y, 28.0f, 3),
+		Player::Player(std::shared_ptr<Time::Stopwatch> stopwatch) :
 			fireCooldown(0.4, stopwatch),
-			speed(200), bulletSpeed(400.0), bulletDmg(1)
+			speed(200), speedUpVal(0),
+			bulletSpeed(400.0), bulletSpeedUpVal(0),
+			bulletDmg(1), bulletDmgUpVal(0)
 		{}
 		
 		void Player::speedUp(){
@@ -111,218 +37,115 @@ namespace SI {
 			fireCooldown.setPeriod(0.4);
 		}
 
-		void Player::shoot(){
-			if (fireCooldown()) {
-				model->addEntity(std::make_shared<Md::PlayerBullet>(xpos, ypos, 0, -(bulletSpeed + bulletSpeedUpVal), 0, -200, bulletDmg + bulletDmgUpVal));
-				model->addEvent(Event(friendlyShotFired));
-			}
+		bool Player::fire(){
+			return fireCooldown();
 		}
 
-		void Player::moveLeft(double dt){
-			if (xpos < 50){
-				xpos = 50.0f;
-				return;
-			}
-			xpos -= dt * (speed + speedUpVal);
-			updatePosition();
+		double Player::getSpeed() const {
+			return speed + speedUpVal;
 		}
 
-		void Player::moveRight(double dt){
-			if (xpos > 750) {
-				xpos = 750.0f;
-				return;
-			}
-			xpos += dt * (speed + speedUpVal);
-			updatePosition();
+		double Player::getBulletSpeed() const {
+			return bulletSpeed + bulletSpeedUpVal;
 		}
 
-		// Bullet : Entity
-
-		inline Bullet::Bullet( EntityType type, double xpos, double ypos, double xvel, double yvel, double xacc, double yacc, float size, int health) :
-			Entity(type, xpos, ypos, size, health),
-			xvel(xvel), yvel(yvel),
-			xacc(xacc), yacc(yacc)
-		{}
-
-		void Bullet::tick(double dt) {
-			xpos += xvel * dt;
-			ypos += yvel * dt;
-			xvel += xacc * dt;
-			yvel += yacc * dt;
-			updatePosition();
-		}
-
-		void Bullet::hurt(std::shared_ptr<Barrier> e){
-			model->addEvent(Event(bulletHit, xpos, ypos));
-			model->addEvent(Event(barrierHit, e->getX(), e->getY()));
-
-			int min = std::min(health, e->getHealth());
-			health -= min;
-			e->setHealth(e->getHealth() - min);
-
-			updateHealth();
-			e->updateHealth();
-			if (e->isDead()) {
-				model->deleteEntity(e);
-				model->addEvent(Event(barrierDestroyed, e->getX(), e->getY()));
-			}
-		}
-
-		// EnemyBullet : Bullet
-
-		EnemyBullet::EnemyBullet(double xpos, double ypos, double xvel, double yvel, double xacc, double yacc, int health) :
-			Bullet( EntityType::enemyBullet, xpos, ypos, xvel, yvel, xacc, yacc, (float)(5 + health * 5), health)
-		{}
-
-		void EnemyBullet::hurt(std::shared_ptr<Player> e){
-			model->addEvent(Event(bulletHit, xpos, ypos));
-			health = 0;
-			e->setHealth(e->getHealth() - 1);
-
-			updateHealth();
-			e->updateHealth();
+		int Player::getBulletDmg() const {
+			return bulletDmg + bulletDmgUpVal;
 		}
 
-		// PlayerBullet : Bullet
-
-		PlayerBullet::PlayerBullet(double xpos, double ypos, double xvel, double yvel, double xacc, double yacc, int health) :
-			Bullet( EntityType::playerBullet, xpos, ypos, xvel, yvel, xacc, yacc, (float)(5 + health * 5), health)
-		{}
-
-		void PlayerBullet::hurt(std::shared_ptr<Enemy> e){
-			model->addEvent(Event(bulletHit, xpos, ypos));
-			model->addEvent(Event(enemyHit, e->getX(), e->getY()));
-
-			int min = std::min(health, e->getHealth());
-			health -= min;
-			e->setHealth(e->getHealth() - min);
-
-			updateHealth();
-			e->updateHealth();
-
-			if (e->isDead()) {
-				model->deleteEntity(e);
-				e->destroyEvent();
-			}
-		}
-
-		// Barrier : Entity
-
-		Barrier::Barrier(double xpos, double ypos, int health) :
-			Entity(EntityType::barrier, xpos, ypos, 20.0f, health) {}
-
-		// Enemy : Entity
-
-		Enemy::Enemy(EntityType type, double x, double y, int health) :
-			Entity(type, x, y, 35.0f, health), rng(RNG::RNG::getInstance()) {}
-
-		void Enemy::tick(double dt){
-			if (rng->chanceOutOf(0.1 * dt)) {
-				shoot();
-			}
-		}
-
-		// SmallEnemy : Enemy
-
-		SmallEnemy::SmallEnemy(double x, double y, int health) : Enemy(smallEnemy, x, y, health) {}
-
-		void SmallEnemy::shoot() {
-			model->addEntity(std::make_shared<Md::EnemyBullet>(xpos, ypos, rng->intFromRange(-30, 30), 300, 0, 0, 1));
-			model->addEvent(Event(EventType::enemyShotFired));
-		}
+		// EnemyCluster
 
-		void SmallEnemy::hurt(std::shared_ptr<Barrier> e){
-			int min = std::min(health, 1 + e->getHealth() / 2);	// Take at least 1 damage, + 1 damage for every 2 hp the barrier has
-			health -= min;
-			model->addEvent(Event(bulletHit, (e->getX()+xpos)/2, (e->getY() + ypos) / 2));	// create an explosion between the barrier and alien
-			updateHealth();
-			
-			e->setHealth(e->getHealth() - min * 2);
-			if (e->isDead()) {
-				model->deleteEntity(e);
-				model->addEvent(Event(barrierDestroyed, e->getX(), e->getY()));
+		void EnemyCluster::findBounds() {
+			// Lowest actually means highest since y increases downwards
+			left = std::numeric_limits<double>::max();
+			right = low = std::numeric_limits<double>::min();
+			for (EntityType type : { smallEnemy, bigEnemy }) {
+				const EntityArray& enemies = entities[type];
+				for (unsigned int i = 0; i < enemies.count(); ++i) {
+					if (enemies.isRemoved(i))
+						continue;
+					left = std::min(left, enemies.x[i] - enemies.size[i]);
+					right = std::max(right, enemies.x[i] + enemies.size[i]);
+					low = std::max(low, enemies.y[i] + enemies.size[i]);
+				}
 			}
-			e->updateHealth();
+			boundsDirty = false;
 		}
 
-		void SmallEnemy::destroyEvent(){
-			model->addEvent(Event(smallEnemyDestroyed, xpos, ypos));
-			if (rng->chanceOutOf(1, 8))
-				model->addEntity(std::make_shared<Md::Powerup>(xpos, ypos));
-		}
-
-		// BigEnemy : Enemy
-
-		BigEnemy::BigEnemy(double x, double y, int health) : Enemy(bigEnemy, x, y, health) {}
-
-		void BigEnemy::shoot() {
-			model->addEntity(std::make_shared<Md::EnemyBullet>(xpos, ypos, rng->intFromRange(-20, 20), 200, 0, 0, 2));
-			model->addEvent(Event(EventType::enemyShotFired));
+		double EnemyCluster::rightMostPoint() {
+			if (boundsDirty)
+				findBounds();
+			return entities[smallEnemy].originX + right;
 		}
 
-		void BigEnemy::hurt(std::shared_ptr<Barrier> e){
-			// Straight-up destroy the barrier without taking damage
-			model->addEvent(Event(bulletHit, (e->getX() + xpos) / 2, (e->getY() + ypos) / 2));	// create an explosion between the barrier and alien
-			model->deleteEntity(e);
-			model->addEvent(Event(barrierDestroyed, e->getX(), e->getY()));
+		double EnemyCluster::leftMostPoint(){
+			if (boundsDirty)
+				findBounds();
+			return entities[smallEnemy].originX + left;
 		}
 
-		void BigEnemy::destroyEvent(){
-			model->addEvent(Event(bigEnemyDestroyed, xpos, ypos));
-			if (rng->chanceOutOf(1, 2))
-				model->addEntity(std::make_shared<Md::Powerup>(xpos, ypos));
+		double EnemyCluster::lowestPoint(){
+			if (boundsDirty)
+				findBounds();
+			return entities[smallEnemy].originY + low;
 		}
 
-		// EnemyCluster
-
-		double EnemyCluster::rightMostPoint() {
-			double right = std::numeric_limits<double>::min();
-			for (auto& enemy : enemies)
-				right = std::max(right, enemy->getX() + enemy->getSize());
-			return right;
+		void EnemyCluster::moveTo(double x, double y) {
+			for (EntityType type : { smallEnemy, bigEnemy })
+				entities[type].setOrigin(x, y);
 		}
 
-		double EnemyCluster::leftMostPoint(){
-			double left = std::numeric_limits<double>::max();
-			for (auto& enemy : enemies)
-				left = std::min(left, enemy->getX() - enemy->getSize());
-			return left;
+		void Player::save(Snapshot& out) const {
+			fireCooldown.save(out);
+			out.write(speedUpVal);
+			out.write(bulletSpeedUpVal);
+			out.write(bulletDmgUpVal);
 		}
 
-		double EnemyCluster::lowestPoint(){
-			// Lowest actually means highest since y increases downwards
-			double low = std::numeric_limits<double>::min();
-			for (auto& enemy : enemies)
-				low = std::max(low, enemy->getY() + enemy->getSize());
-			return low;
+		void Player::load(Snapshot::Reader& in) {
+			fireCooldown.load(in);
+			in.read(speedUpVal);
+			in.read(bulletSpeedUpVal);
+			in.read(bulletDmgUpVal);
 		}
 
-		EnemyCluster::EnemyCluster(std::shared_ptr<Time::Stopwatch> stopwatch) :
-			xDir(true), yDistance(-1.0f), initialCount(0), frozen(3.0, true, stopwatch){}
+		EnemyCluster::EnemyCluster(EntityStore& entities, std::shared_ptr<Time::Stopwatch> stopwatch) :
+			entities(entities), frozen(3.0, true, stopwatch), initialCount(0), speed(0), speedInc(0), xDir(true), yDistance(-1.0f),
+			left(0), right(0), low(0), boundsDirty(true){}
 
 		void EnemyCluster::setSpeed(double speed, double speedInc){
 			this->speed = speed;
 			this->speedInc = speedInc;
 		}
 
-		void EnemyCluster::addEnemy(std::shared_ptr<Enemy> enemy){
-			enemies.push_back(enemy);
-		}
-
-		void EnemyCluster::deleteEnemy(std::shared_ptr<Enemy> enemy){
-			enemies.erase(std::remove(enemies.begin(), enemies.end(), enemy), enemies.end());
-		}
-
 		void EnemyCluster::clear(){
 			xDir = true;
 			yDistance = -1.0;
-			enemies.clear();
 			initialCount = 0;
 			frozen.forceFalse();
+			left = right = low = 0;
+			boundsDirty = true;
+			moveTo(0, 0);
 		}
 
 		unsigned int EnemyCluster::count(){
-			return enemies.size();
+			return entities[smallEnemy].count() + entities[bigEnemy].count();
+		}
+
+		void EnemyCluster::enemyAdded(EntityType type, unsigned int i) {
+			if (boundsDirty)
+				return;
+			const EntityArray& enemies = entities[type];
+			left = std::min(left, enemies.x[i] - enemies.size[i]);
+			right = std::max(right, enemies.x[i] + enemies.size[i]);
+			low = std::max(low, enemies.y[i] + enemies.size[i]);
+		}
+
+		void EnemyCluster::enemyRemoved(EntityType type, unsigned int i) {
+			// Only an enemy on an edge can change the bounds, the new edge can be anywhere though
+			const EntityArray& enemies = entities[type];
+			if (enemies.x[i] - enemies.size[i] == left || enemies.x[i] + enemies.size[i] == right || enemies.y[i] + enemies.size[i] == low)
+				boundsDirty = true;
 		}
 
 		void EnemyCluster::tick(double dt){
@@ -348,40 +171,72 @@ namespace SI {
 					yDistance -= yd;
 			}
 
-			for (auto& enemy : enemies){
-				enemy->setY( enemy->getY() + yd);
-				enemy->setX(enemy->getX() + xd);
-				enemy->updatePosition();
-			}
+			// The enemies and the bounds are relative to the origin, so they all move along with it
+			if (xd != 0 || yd != 0)
+				moveTo(entities[smallEnemy].originX + xd, entities[smallEnemy].originY + yd);
 		}
 
 		void EnemyCluster::freeze(){
 			frozen.reset();
 		}
 
-		// Powerup : Entity
-
-		Powerup::Powerup(double xpos, double ypos) : 
-			Entity(powerup, xpos, ypos, 10.0, 1), yvel(100.0)
-		{}
-
-		PowerupType Powerup::getPowerupType(){
-			const auto& rng = RNG::RNG::getInstance();
-			if (rng->chanceOutOf(1, 5))	
+		void EnemyCluster::save(Snapshot& out) const {
+			frozen.save(out);
+			out.write(initialCount);
+			out.write(speed);
+			out.write(speedInc);
+			out.write(xDir);
+			out.write(yDistance);
+			out.write(left);
+			out.write(right);
+			out.write(low);
+			out.write(boundsDirty);
+		}
+
+		void EnemyCluster::load(Snapshot::Reader& in) {
+			frozen.load(in);
+			in.read(initialCount);
+			in.read(speed);
+			in.read(speedInc);
+			in.read(xDir);
+			in.read(yDistance);
+			in.read(left);
+			in.read(right);
+			in.read(low);
+			in.read(boundsDirty);
+		}
+
+		// Helper functions
+
+		PowerupType randomPowerupType(RNG::RNG& rng){
+			if (rng.chanceOutOf(1, 5))	
 				return slowdown;
-			if (rng->chanceOutOf(1, 4))	
+			if (rng.chanceOutOf(1, 4))	
 				return speedUp;
-			if (rng->chanceOutOf(1, 3))	
+			if (rng.chanceOutOf(1, 3))	
 				return bulletSpeedUp;
-			if (rng->chanceOutOf(1, 2))	
+			if (rng.chanceOutOf(1, 2))	
 				return fireRateUp;
 			return damageUp;
 		}
 
-		void Powerup::tick(double dt){
-			ypos += yvel * dt;
-			yvel += 50.0 * dt;
-			updatePosition();
+		float entitySize(EntityType type, int health){
+			switch (type) {
+			case player:
+				return 28.0f;
+			case smallEnemy:
+			case bigEnemy:
+				return 35.0f;
+			case playerBullet:
+			case enemyBullet:
+				return (float)(5 + health * 5);
+			case barrier:
+				return 20.0f;
+			case powerup:
+				return 10.0f;
+			default:
+				throw(std::runtime_error("Attempted to get the size of an invalid EntityType: " + std::to_string(type)));
+			}
 		}
 	}
 }
@@ -0,0 +1,94 @@
+#include "StdAfx.h"
+#include "events.h"
+
+#include <deque>
+#include <mutex>
+
+namespace SI {
+	namespace Md {
+
+		// Helper functions
+
+		// The interned texts, indexed by their id, and the lock guarding them
+		// A deque, so that references to texts stay valid as more texts are interned
+		static std::deque<std::string> texts(1);
+		static std::mutex textsLock;
+
+		TextId internText(const std::string& text) {
+			std::lock_guard<std::mutex> lock(textsLock);
+			auto it = std::find(texts.begin(), texts.end(), text);
+			if (it != texts.end())
+				return (TextId)(it - texts.begin());
+			texts.push_back(text);
+			return (TextId)(texts.size() - 1);
+		}
+
+		const std::string& internedText(TextId id) {
+			std::lock_guard<std::mutex> lock(textsLock);
+			if (id >= texts.size())
+				throw(std::runtime_error("Attempted to get an unknown interned text."));
+			return texts[id];
+		}
+
+		// Event
+
+		Event::Event(EventType type, double x, double y, TextId text) :
+			x(x), y(y), type(type), text(text) {}
+
+		double Event::getX() const {
+			return x;
+		}
+
+		double Event::getY() const {
+			return y;
+		}
+
+		EventType Event::getType() const {
+			return type;
+		}
+
+		const std::string& Event::getText() const {
+			return internedText(text);
+		}
+
+		static_assert(std::is_trivially_copyable<Event>::value, "Events are copied into the ring as plain data");
+
+		// EventRing
+
+		EventRing::EventRing(unsigned int capacity) : events(capacity), written(0) {
+			if (!capacity || (capacity & (capacity - 1)))
+				throw(std::runtime_error("The capacity of an EventRing has to be a power of two."));
+		}
+
+		void EventRing::push(const Event& event) {
+			events[written & (events.size() - 1)] = event;
+			++written;
+		}
+
+		EventRing::Cursor EventRing::end() const {
+			Cursor cursor;
+			cursor.position = written;
+			return cursor;
+		}
+
+		const Event* EventRing::next(Cursor& cursor) const {
+			if (cursor.position == written)
+				return nullptr;
+			if (written - cursor.position > events.size()) {
+				// Skip the events that have been overwritten in the meantime
+				cursor.lost += written - cursor.position - events.size();
+				cursor.position = written - events.size();
+			}
+			return &events[cursor.position++ & (events.size() - 1)];
+		}
+
+		unsigned int EventRing::capacity() const {
+			return events.size();
+		}
+
+		std::uint64_t EventRing::getWritten() const {
+			return written;
+		}
+
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "StdAfx.h"
+
+namespace SI {
+	namespace Md {
+
+		// An enum representing a type of event
+		enum EventType {
+			friendlyShotFired, bulletHit, friendlyHit, pickup,
+			enemyHit, enemyShotFired, smallEnemyDestroyed, bigEnemyDestroyed,
+			barrierHit, barrierDestroyed,
+			paused, unPaused, gameOver
+		};
+
+		// The number of different EventTypes, used to size per-type collections
+		const unsigned int eventTypeCount = gameOver + 1;
+
+		// The id of an interned text, so that events can refer to text without carrying a string around
+		typedef std::uint32_t TextId;
+
+		// The id of the empty text, for events without text
+		const TextId noText = 0;
+
+		// Get the id of a text, interning it if it's new
+		// Meant to be called once per text, keeping the id, rather than every time the text is used
+		TextId internText(const std::string& text);
+
+		// Get the text with the given id
+		const std::string& internedText(TextId id);
+
+		// A struct representing type of event, and possibly its location and related text
+		// Plain data, so that events can be written into and read from an EventRing without allocating anything
+		struct Event {
+		protected:
+			// The optional x and y values of the event
+			double x, y;
+
+			// The type of the event
+			EventType type;
+
+			// The optional text of the event, interned
+			TextId text;
+		public:
+			Event() = default;
+			Event(EventType type, double x = 0, double y = 0, TextId text = noText);
+
+			// Get the x value
+			double getX() const;
+
+			// Get the y value
+			double getY() const;
+
+			// Get the text value
+			const std::string& getText() const;
+
+			// Get the event's type
+			EventType getType() const;
+		};
+
+		// A fixed number of the latest events, written once by the model and read by every observer through its own cursor
+		// Readers that fall behind by more than the capacity lose the oldest events, which their cursor counts
+		class EventRing {
+		public:
+			// A reader's position in the ring
+			struct Cursor {
+				// The number of events written before the next event to read
+				std::uint64_t position = 0;
+
+				// The number of events overwritten before they were read
+				std::uint64_t lost = 0;
+			};
+
+		private:
+			// The ring of events, its size a power of two
+			std::vector<Event> events;
+
+			// The number of events ever written
+			std::uint64_t written;
+
+		public:
+			// Make a ring of 'capacity' events, which has to be a power of two
+			EventRing(unsigned int capacity = 1024);
+
+			// Write an event, overwriting the oldest one if the ring is full
+			void push(const Event& event);
+
+			// Get a cursor right after the latest event, which only reads the events written after it was made
+			Cursor end() const;
+
+			// Get the next event to read and move the cursor past it, or nullptr if the cursor has read every event
+			// The event stays valid until 'capacity' more events are written
+			const Event* next(Cursor& cursor) const;
+
+			// Get the number of events the ring holds
+			unsigned int capacity() const;
+
+			// Get the number of events ever written
+			std::uint64_t getWritten() const;
+		};
+
+	}
+}
@@ -0,0 +1,41 @@
+#include "StdAfx.h"
+#include "feed.h"
+
+namespace SI {
+	namespace Md {
+
+	// ModelFeed
+
+		void ModelFeed::publish(const MirrorObserver& mirror, const std::vector<Event>& popped, TimePoint stepTime, double stepPeriod) {
+			for (const Event& event : popped)
+				events.push(event);
+			// Copying over an older copy reuses its storage
+			State& next = state.write();
+			next.mirror = mirror;
+			next.stepTime = stepTime;
+			next.stepPeriod = stepPeriod;
+			state.publish();
+		}
+
+		bool ModelFeed::update() {
+			return state.update();
+		}
+
+		const MirrorObserver& ModelFeed::read() const {
+			return state.read().mirror;
+		}
+
+		double ModelFeed::getStepFraction(TimePoint now) const {
+			const State& current = state.read();
+			if (current.stepPeriod <= 0)
+				return 1;
+			double fraction = Time::nanoToSeconds(now - current.stepTime) / current.stepPeriod;
+			return std::min(std::max(fraction, 0.0), 1.0);
+		}
+
+		bool ModelFeed::popEvent(Event& out) {
+			return events.pop(out);
+		}
+
+	}
+}
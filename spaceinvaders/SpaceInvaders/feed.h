@@ -0,0 +1,52 @@
+#pragma once
+
+#include "StdAfx.h"
+#include "observer.h"
+#include "handoff.h"
+#include "stopwatch.h"
+
+namespace SI {
+	namespace Md {
+
+		// The state of a model as published by the thread simulating it, for a view drawing it on another thread
+		// The simulation thread publishes a copy of its MirrorObserver after every tick, along with the events it popped
+		// from it, and the view takes the latest copy whenever it draws a frame, neither thread ever waiting on the other
+		class ModelFeed {
+		private:
+			// A published state of the model, along with when its latest step was due in real time
+			struct State {
+				MirrorObserver mirror;
+
+				// The moment the latest step was due, and the number of seconds of real time between steps
+				TimePoint stepTime;
+				double stepPeriod = 0;
+			};
+
+			// The latest published state of the model
+			// The events of the copies are never popped, they are passed on through 'events'
+			TripleBuffer<State> state;
+
+			// The events popped since the state was last published
+			SpscQueue<Event, 1024> events;
+
+		public:
+			// As the simulation thread, publish a copy of the state of 'mirror', and the events popped from it since the last time
+			// Its latest step was due at 'stepTime', and the next one is due 'stepPeriod' seconds later
+			void publish(const MirrorObserver& mirror, const std::vector<Event>& popped, TimePoint stepTime, double stepPeriod);
+
+			// As the view, take the latest published state if there is a newer one, returns whether or not there was
+			bool update();
+
+			// As the view, get the state that was last taken
+			const MirrorObserver& read() const;
+
+			// As the view, get how far 'now' is from the latest step of the state that was last taken to the step after it,
+			// from 0 to 1, for drawing the entities in between their last two positions
+			double getStepFraction(TimePoint now) const;
+
+			// As the view, pop the next event into 'out', returns false if there is none
+			bool popEvent(Event& out);
+		};
+
+	}
+}
@@ -3,29 +3,192 @@
 
 namespace SI {
 	
-	// Variable determining the minimum time between 2 ticks in the model
-	double modelUpdateInterval = 1.0/120.0;
+	// Variable determining the length of a single simulation step in the model
+	// The views draw the entities in between steps, so the model can step less often than they draw frames
+	double modelStepLength = 1.0/60.0;
 
-	Game::Game() {
-		model = std::unique_ptr<Md::Model>(new Md::Model(modelUpdateInterval));
-		controller = std::make_shared<Ctrl::Controller>(0.0);
-		model->registerController(controller);
+	// Variable determining the most steps the model may take in one tick to catch up with real time
+	unsigned int modelMaxCatchUpSteps = 8;
+
+	// Variable determining how the model finds colliding entities
+	// Testing every pair is faster on the shipped levels, the grid only wins on levels denser than any of them
+	Md::CollisionMode collisionMode = Md::CollisionMode::bruteForce;
+
+	// Variable determining the file the session's input is recorded to, empty to not record
+	std::string replayRecordFile = "";
+
+	// Variable determining the replay file to play back instead of reading the keyboard, empty to play normally
+	std::string replayPlaybackFile = "";
+
+	// Variable determining how much faster than real time a replay is played back
+	double replayPlaybackSpeed = 4.0;
+
+	// Variable determining the local player of a netplay session: 0 to play alone, 1 to host a session or 2 to join one
+	unsigned int netplayPlayer = 0;
+
+	// Variables determining the local UDP port of a netplay session, and the host and port of the peer
+	unsigned short netplayPort = 7001;
+	std::string netplayPeerHost = "127.0.0.1";
+	unsigned short netplayPeerPort = 7002;
+
+	// Variables determining the most steps a netplay session may roll back, and the number of steps local input is held back
+	unsigned int netplayMaxRollback = 8;
+	unsigned int netplayInputDelay = 2;
+
+	// Variable determining the clock real time is read from: "system", "coarse" or "tsc"
+	std::string clockSource = "system";
+
+	// Variable determining the period between reading the keyboard, the loop drawing the views sleeps in between
+	double controllerUpdatePeriod = 1.0 / 120.0;
+
+	// Variable determining whether or not the pacing of the game's loops is logged when the game ends
+	bool logPacing = false;
+
+	Game::Game() : simulating(false) {
+		if (netplayPlayer && (!replayPlaybackFile.empty() || !replayRecordFile.empty()))
+			throw(std::runtime_error("A netplay session can't be recorded or played back."));
+
+		Time::GlobalStopwatch::getInstance()->setClock(Time::makeClock(clockSource));
+		std::shared_ptr<Ctrl::Replay> playback;
+		if (!replayPlaybackFile.empty()) {
+			std::ifstream file(replayPlaybackFile, std::ios::binary);
+			if (!file)
+				throw(std::runtime_error("Failed to open replay file: " + replayPlaybackFile));
+			playback = std::make_shared<Ctrl::Replay>(Ctrl::Replay::load(file));
+		}
+
+		// A replay is played back with the step length it was recorded with
+		double stepLength = playback ? playback->getStepLength() : modelStepLength;
+		model = std::unique_ptr<Md::Model>(new Md::Model(stepLength, modelMaxCatchUpSteps));
+		model->setCollisionMode(collisionMode);
+		controller = std::make_shared<Ctrl::Controller>(controllerUpdatePeriod);
+		input = std::make_shared<Ctrl::InputHandoff>();
+		mirror = std::make_shared<Md::MirrorObserver>();
+		model->registerObserver(mirror);
+
+		if (playback) {
+			replayPlayer = std::unique_ptr<Md::ReplayPlayer>(new Md::ReplayPlayer(*model, playback));
+			model->setTimeScale(replayPlaybackSpeed);
+		} else if (netplayPlayer) {
+			// The session plays the keyboard's input as the local player and the peer's as the other
+			auto link = std::make_shared<Ctrl::UdpLink>(netplayPort, netplayPeerHost, netplayPeerPort);
+			session = std::unique_ptr<Md::RollbackSession>(new Md::RollbackSession(*model, input, link, netplayPlayer - 1,
+				RNG::RNG::randomSeed(), 0, netplayMaxRollback, netplayInputDelay));
+		} else if (!replayRecordFile.empty()) {
+			std::uint64_t seed = RNG::RNG::randomSeed();
+			model->seed(seed);
+			auto replay = std::make_shared<Ctrl::Replay>(seed, 0, stepLength);
+			model->registerInputSource(std::make_shared<Ctrl::RecordingInput>(input, replay, replayRecordFile));
+		} else {
+			model->registerInputSource(input);
+		}
 	}
 
 	void Game::registerView( std::shared_ptr<Vw::View> view ){
-		model->registerView(view);
+		feeds.push_back(view->getFeed());
 		views.push_back(view);
 	}
 
 	void Game::run() {
-		model->reset();
-		while (true) {
-			controller->update();
-			model->tick();
-			updateViews();
+		if (replayPlayer)
+			replayPlayer->restart();
+		else
+			model->reset();
+		publish();
+
+		// From here on only the simulation thread touches the model
+		simulating = true;
+		std::thread simulation(&Game::simulate, this);
+		try {
+			while (simulating && isRunning()) {
+				// Read the clock once for the whole iteration, the timers running in real time only see time pass here
+				Time::GlobalStopwatch::getInstance()->sample();
+				controller->update();
+				input->publish(controller->getInput());
+				updateViews();
+
+				// Sleep until the keyboard is due to be read or a view is due to draw a frame, whichever comes first
+				TimePoint next = controller->getNextUpdate();
+				for (const std::shared_ptr<Vw::View>& view : views)
+					next = std::min(next, view->getNextFrame());
+				renderPacer.waitUntil(next);
+			}
+		} catch (...) {
+			// The simulation thread has to be joined before the exception may leave
+			simulating = false;
+			simulation.join();
+			throw;
+		}
+		simulating = false;
+		simulation.join();
+		if (simulationError)
+			std::rethrow_exception(simulationError);
+
+		if (logPacing) {
+			std::cout << "Simulation pacing: " << simulationPacer.getStats() << std::endl;
+			std::cout << "Render pacing: " << renderPacer.getStats() << std::endl;
+		}
+		if (session) {
+			const Md::NetplayStats& netStats = session->getStats();
+			std::cout << "Netplay: " << session->getSteps() << " steps, rollbacks: " << netStats.rollbacks
+				<< ", stalls: " << netStats.stalls << ", desyncs: " << netStats.desyncs << std::endl;
+		}
+	}
+
+	void Game::simulate() {
+		// The stopwatch is sampled by the other thread, the clock is read directly instead
+		std::shared_ptr<Time::GlobalStopwatch> stopwatch = Time::GlobalStopwatch::getInstance();
+		try {
+			while (simulating) {
+				if (session && !session->isSynchronized()) {
+					// Keep greeting the peer until both ends play the same game, the session resets the model when they do
+					if (session->synchronize()) {
+						model->dueSteps(stopwatch->read());
+						publish();
+					} else {
+						std::this_thread::sleep_for(std::chrono::milliseconds(20));
+					}
+					continue;
+				}
+
+				// Take in the peer's input first, rolling back any steps it turns out to have been mispredicted in
+				if (session)
+					session->poll();
+				unsigned int steps = model->dueSteps(stopwatch->read());
+				if (steps) {
+					for (; steps; --steps) {
+						if (session)
+							session->advance();
+						else
+							model->step();
+					}
+					publish();
+				}
+				// Sleep until the next step is due
+				simulationPacer.waitUntil(model->nextStepTime());
+			}
+		} catch (std::exception&) {
+			// Stop the game, the thread running it rethrows the exception
+			simulationError = std::current_exception();
+			simulating = false;
 		}
 	}
 
+	void Game::publish() {
+		events.clear();
+		while (const Md::Event* event = mirror->popEvent())
+			events.push_back(*event);
+		for (std::shared_ptr<Md::ModelFeed>& feed : feeds)
+			feed->publish(*mirror, events, model->lastStepTime(), model->getStepPeriod());
+	}
+
+	bool Game::isRunning() const {
+		for (const std::shared_ptr<Vw::View>& view : views)
+			if (!view->isOpen())
+				return false;
+		return true;
+	}
+
 	void Game::updateViews() {
 		for (std::shared_ptr<Vw::View> view : views) {
 			view->update();
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "model.h"
+#include "playback.h"
+#include "netplay.h"
 #include "controller.h"
 #include "view.h"
+#include "feed.h"
 #include "time.h"
+#include "pacer.h"
 #include "random.h"
 
 
@@ -22,15 +26,54 @@ namespace SI {
 		// The controller
 		std::shared_ptr<Ctrl::Controller> controller;
 
+		// Plays back a replay instead of the controller, if one is being played back
+		std::unique_ptr<Md::ReplayPlayer> replayPlayer;
+
+		// Plays the game against a peer over the network, if a netplay session is being played
+		std::unique_ptr<Md::RollbackSession> session;
+
+		// The input read by the controller, handed over to the simulation thread
+		std::shared_ptr<Ctrl::InputHandoff> input;
+
+		// The model's observer on the simulation thread, whose state is published to the views
+		std::shared_ptr<Md::MirrorObserver> mirror;
+
+		// The feeds the model's state is published to, one for every view
+		std::vector<std::shared_ptr<Md::ModelFeed>> feeds;
+
+		// The events popped from the observer for publishing, kept to reuse its storage
+		std::vector<Md::Event> events;
+
+		// Whether or not the simulation thread should keep running
+		std::atomic<bool> simulating;
+
+		// The exception the simulation thread stopped on, if any, rethrown by run() once the thread has been joined
+		std::exception_ptr simulationError;
+
+		// The pacers putting the simulation thread and the thread drawing the views to sleep until they're due
+		Time::Pacer simulationPacer;
+		Time::Pacer renderPacer;
+
+		// Simulate the model in real time on a thread of its own, for as long as 'simulating' is set
+		// An exception clears 'simulating' and is kept in 'simulationError'
+		void simulate();
+
+		// Publish the model's state to every view's feed
+		void publish();
+
 	public:
 		Game();
 
 		// Register a view
 		void registerView( std::shared_ptr<Vw::View> view );
 
-		// Begin running the game, endlessly
+		// Begin running the game, until a view is closed
+		// The model is simulated on a thread of its own, while the calling thread reads the input and draws the views
 		void run();
 
+		// Check whether or not every view is still open
+		bool isRunning() const;
+
 		// Update all views
 		void updateViews();
 
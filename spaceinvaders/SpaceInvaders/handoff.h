@@ -0,0 +1,110 @@
+#pragma once
+
+#include "StdAfx.h"
+#include <atomic>
+
+namespace SI {
+
+	// Hands the latest value of type T over from a single writing thread to a single reading thread, without locking
+	// Three copies are kept: the one the writer fills, the one the reader reads, and the latest published one in between,
+	// so neither thread ever waits on the other and the reader always takes the latest published value
+	// Values published in between the reader's updates are skipped
+	template <typename T>
+	class TripleBuffer {
+	private:
+		// The bit of 'middle' set if the middle copy has been published since the reader last took it
+		static const unsigned int freshBit = 4;
+
+		// The three copies
+		std::array<T, 3> slots;
+
+		// The index of the copy in between the writer and the reader, or'ed with freshBit
+		std::atomic<unsigned int> middle;
+
+		// The index of the copy the writer fills, only touched by the writer
+		unsigned int back;
+
+		// The index of the copy the reader reads, only touched by the reader
+		unsigned int front;
+
+	public:
+		TripleBuffer() : middle(1), back(0), front(2) {}
+
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+		// As the writer, get the copy to fill before publishing it
+		// It holds an older value, which has to be overwritten entirely
+		T& write() {
+			return slots[back];
+		}
+
+		// As the writer, publish the copy that was filled, replacing any published copy the reader hasn't taken yet
+		void publish() {
+			back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & ~freshBit;
+		}
+
+		// As the reader, take the latest published copy if one was published since the last update
+		// Returns whether or not there was one
+		bool update() {
+			if (!(middle.load(std::memory_order_acquire) & freshBit))
+				return false;
+			front = middle.exchange(front, std::memory_order_acq_rel) & ~freshBit;
+			return true;
+		}
+
+		// As the reader, get the copy that was last taken
+		const T& read() const {
+			return slots[front];
+		}
+	};
+
+	// A bounded queue of values of type T from a single writing thread to a single reading thread, without locking
+	// Values pushed while the queue is full are dropped and counted
+	template <typename T, unsigned int capacity>
+	class SpscQueue {
+	private:
+		// The values, as a ring
+		std::array<T, capacity> slots;
+
+		// The number of values ever popped and pushed, each written by a single thread
+		std::atomic<std::uint64_t> popped, pushed;
+
+		// The number of values dropped because the queue was full, only touched by the writer
+		std::uint64_t dropped;
+
+	public:
+		SpscQueue() : popped(0), pushed(0), dropped(0) {}
+
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		// As the writer, push a value, returns false if it was dropped because the queue is full
+		bool push(const T& value) {
+			std::uint64_t p = pushed.load(std::memory_order_relaxed);
+			if (p - popped.load(std::memory_order_acquire) == capacity) {
+				++dropped;
+				return false;
+			}
+			slots[p % capacity] = value;
+			pushed.store(p + 1, std::memory_order_release);
+			return true;
+		}
+
+		// As the reader, pop the oldest value into 'out', returns false if the queue is empty
+		bool pop(T& out) {
+			std::uint64_t p = popped.load(std::memory_order_relaxed);
+			if (p == pushed.load(std::memory_order_acquire))
+				return false;
+			out = slots[p % capacity];
+			popped.store(p + 1, std::memory_order_release);
+			return true;
+		}
+
+		// As the writer, get the number of values dropped because the queue was full
+		std::uint64_t getDropped() const {
+			return dropped;
+		}
+	};
+
+}
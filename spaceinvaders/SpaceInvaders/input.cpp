@@ -0,0 +1,82 @@
+#include "StdAfx.h"
+#include "input.h"
+
+namespace SI {
+	namespace Ctrl {
+
+	// ScriptedInput : public InputSource
+
+		ScriptedInput::ScriptedInput(std::vector<InputState> script) : script(script), index(0) {
+			if (script.empty())
+				throw(std::runtime_error("An input script needs at least one entry."));
+		}
+
+		std::vector<InputState> ScriptedInput::sweep(unsigned int period) {
+			InputState leftShoot, rightShoot;
+			leftShoot[left] = leftShoot[shoot] = true;
+			rightShoot[right] = rightShoot[shoot] = true;
+
+			std::vector<InputState> out(period, leftShoot);
+			out.insert(out.end(), period, rightShoot);
+			return out;
+		}
+
+		std::vector<InputState> ScriptedInput::parse(std::istream& in) {
+			std::vector<InputState> out;
+			std::string line;
+			while (std::getline(in, line)) {
+				if (!line.empty() && line.back() == '\r')
+					line.pop_back();
+				if (line.empty() || line[0] == '#')
+					continue;
+
+				InputState entry;
+				for (char c : line) {
+					switch (c) {
+					case 'L': entry[left] = true; break;
+					case 'R': entry[right] = true; break;
+					case 'S': entry[shoot] = true; break;
+					case 'P': entry[pause] = true; break;
+					case '.': break;
+					default:
+						throw(std::runtime_error(std::string("Unrecognised input \"") + c + "\" in script."));
+					}
+				}
+				out.push_back(entry);
+			}
+			return out;
+		}
+
+		InputState ScriptedInput::getInput() {
+			InputState out = script[index];
+			index = (index + 1) % script.size();
+			return out;
+		}
+
+	// HeldInput : public InputSource
+
+		HeldInput::HeldInput() {}
+
+		void HeldInput::set(InputState state) {
+			this->state = state;
+		}
+
+		InputState HeldInput::getInput() {
+			return state;
+		}
+
+	// InputHandoff : public InputSource
+
+		InputHandoff::InputHandoff() : held(0), latched(0) {}
+
+		void InputHandoff::publish(InputState state) {
+			held.store(state.to_ulong());
+			latched.fetch_or(state.to_ulong());
+		}
+
+		InputState InputHandoff::getInput() {
+			return InputState(latched.exchange(0) | held.load());
+		}
+
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "StdAfx.h"
+#include <atomic>
+
+namespace SI {
+	namespace Ctrl {
+
+		// An enum representing user input
+		enum Input {
+			left, right, shoot, pause, MAX_INPUTNUM = pause
+		};
+
+		// The set of inputs held during a single step
+		typedef std::bitset<MAX_INPUTNUM + 1> InputState;
+
+		// An interface for anything that can provide the model with input,
+		// be it a keyboard, a script or a recording
+		class InputSource {
+		public:
+			virtual ~InputSource() {}
+
+			// Returns the current input, called exactly once every simulation step
+			virtual InputState getInput() = 0;
+		};
+
+		// An InputSource playing back a fixed script of inputs, one entry per call to getInput(), looping at the end
+		class ScriptedInput : public InputSource {
+		private:
+			// The script
+			std::vector<InputState> script;
+
+			// The index of the next entry
+			unsigned int index;
+
+		public:
+			ScriptedInput(std::vector<InputState> script);
+
+			// Make a script that shoots continuously while sweeping 'period' steps left, then 'period' steps right
+			static std::vector<InputState> sweep(unsigned int period);
+
+			// Parse a script from text, one entry per line made up of the characters L, R, S and P
+			// for left, right, shoot and pause, an entry without input is written as '.', lines starting with '#' are skipped
+			static std::vector<InputState> parse(std::istream& in);
+
+			// Returns the next entry of the script
+			virtual InputState getInput();
+		};
+
+		// An InputSource returning whatever input it was last given, for input that is decided elsewhere
+		class HeldInput : public InputSource {
+		private:
+			// The input being held
+			InputState state;
+
+		public:
+			HeldInput();
+
+			// Hold the given input until another is given
+			void set(InputState state);
+
+			// Returns the input being held
+			virtual InputState getInput();
+		};
+
+		// An InputSource handing over input read on another thread, without locking
+		// Inputs are latched: a step gets every input published since the previous step, as well as the inputs held right now,
+		// so a key tapped in between two steps isn't missed
+		class InputHandoff : public InputSource {
+		private:
+			// The inputs held as last published
+			std::atomic<unsigned long> held;
+
+			// Every input published since the last step
+			std::atomic<unsigned long> latched;
+
+		public:
+			InputHandoff();
+
+			// As the thread reading the input, publish the inputs held right now
+			void publish(InputState state);
+
+			// As the simulating thread, returns the inputs published since the last step and those held right now
+			virtual InputState getInput();
+		};
+
+	}
+}
@@ -1,5 +1,6 @@
 #include "StdAfx.h"
 #include "level.h"
+#include "model.h"
 
 namespace SI {
 	namespace Md {
@@ -9,16 +10,16 @@ namespace SI {
 		LevelEntity::LevelEntity(EntityType type, unsigned int x, unsigned int y, unsigned int health) :
 			type(type), x(x), y(y), health(health) {}
 
-		std::shared_ptr<Entity> LevelEntity::makeEntity() const {
+		void LevelEntity::makeEntity(Model& model) const {
 			switch (type) {
 			case smallEnemy:
-				return std::make_shared<SmallEnemy>(x * 40 + 40, y * 40 + 20, health);
+				model.addEntity(smallEnemy, x * 40 + 40, y * 40 + 20, health);
 				break;
 			case bigEnemy:
-				return std::make_shared<BigEnemy>(x * 40 + 40, y * 40 + 20, health*2);
+				model.addEntity(bigEnemy, x * 40 + 40, y * 40 + 20, health*2);
 				break;
 			case barrier:
-				return std::make_shared<Barrier>(x * 40 + 20, y * 40 + 20, health);
+				model.addEntity(barrier, x * 40 + 20, y * 40 + 20, health);
 				break;
 			default:
 				throw(std::runtime_error("Attempted to generate invalid Entity from LevelEntity: " + std::to_string(type)));
@@ -41,6 +42,14 @@ namespace SI {
 			return name;
 		}
 
+		unsigned int Level::count(EntityType type) const {
+			unsigned int out = 0;
+			for (auto& le : levelEntities)
+				if (le.type == type)
+					++out;
+			return out;
+		}
+
 		void Level::parseLevel(std::ifstream& file) {
 
 			std::string line;
@@ -111,22 +120,18 @@ namespace SI {
 			return bits[1];
 		}
 
-		std::vector<std::shared_ptr<Entity>> Level::makeEntities() {
-
-			std::vector<std::shared_ptr<Entity>> out;
+		void Level::makeEntities(Model& model) {
 			for (auto& le : levelEntities)
-				out.push_back(le.makeEntity());
-
-			return out;
+				le.makeEntity(model);
 		}
 		
 	// LevelParser
 
-		LevelParser::LevelParser(){}
+		LevelParser::LevelParser(std::string directory) : directory(directory) {}
 
 		std::vector<std::shared_ptr<Level>> LevelParser::parseLevels(){
 			
-			std::string prefix = "Assets/levels/level";
+			std::string prefix = directory + "level";
 			std::string suffix = ".txt";
 
 			std::vector<std::shared_ptr<Level>> out;
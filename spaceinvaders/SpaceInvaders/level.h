@@ -6,7 +6,7 @@
 namespace SI {
 	namespace Md {
 
-		class Entity;
+		class Model;
 
 		// An exception thrown when the read input does not follow the input format
 		class bad_parse_exception : public std::runtime_error {
@@ -28,8 +28,8 @@ namespace SI {
 
 			LevelEntity(EntityType type, unsigned int x, unsigned int y, unsigned int health );
 
-			// Create a new entity based off the data stored in the LevelEntity
-			std::shared_ptr<Entity> makeEntity() const;
+			// Add a new entity to the model based off the data stored in the LevelEntity
+			void makeEntity(Model& model) const;
 
 		};
 
@@ -55,6 +55,9 @@ namespace SI {
 
 			// Get the Level's name
 			std::string getName() const; 
+
+			// Get the number of entities of the given type the level starts with
+			unsigned int count(EntityType type) const;
 			
 			// Parse a level file
 			void parseLevel(std::ifstream& file);
@@ -62,19 +65,23 @@ namespace SI {
 			// Parse an attribute from a level file
 			std::string parseAttribute(std::string line, std::string attribute);
 
-			// Create a new vector of new Entities based off the parsed level file
-			std::vector<std::shared_ptr<Entity>> makeEntities();
+			// Add new Entities to the model based off the parsed level file
+			void makeEntities(Model& model);
 
 
 		};
 
 		// A class designed to parse level files and generate a vector of levels
 		class LevelParser {
+		private:
+			// The directory containing the level files
+			std::string directory;
+
 		public:
 
-			LevelParser();
+			LevelParser(std::string directory = "Assets/levels/");
 
-			// Parse all level files and return it as a vector of levels
+			// Parse all level files in the directory and return it as a vector of levels
 			std::vector<std::shared_ptr<Level>> parseLevels();
 
 		};
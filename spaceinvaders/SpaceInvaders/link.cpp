@@ -0,0 +1,155 @@
+#include "StdAfx.h"
+#include "link.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace SI {
+	namespace Ctrl {
+
+		// Helper functions
+
+		// The platform's type of socket handle
+#ifdef _WIN32
+		typedef SOCKET NativeSocket;
+#else
+		typedef int NativeSocket;
+#endif
+
+		// The largest packet that can be received
+		static const std::size_t maxPacketSize = 1500;
+
+		// Close a socket handle
+		static void closeSocket(std::intptr_t handle) {
+#ifdef _WIN32
+			closesocket((NativeSocket)handle);
+#else
+			close((NativeSocket)handle);
+#endif
+		}
+
+	// UdpLink : public Link
+
+		UdpLink::UdpLink(unsigned short localPort, std::string peerHost, unsigned short peerPort) {
+#ifdef _WIN32
+			WSADATA data;
+			if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+				throw(std::runtime_error("Failed to start up Winsock."));
+#endif
+			addrinfo hints = {};
+			hints.ai_family = AF_INET;
+			hints.ai_socktype = SOCK_DGRAM;
+			addrinfo* result = nullptr;
+			if (getaddrinfo(peerHost.c_str(), nullptr, &hints, &result) != 0 || !result)
+				throw(std::runtime_error("Failed to resolve host: " + peerHost));
+			peerAddress = ((sockaddr_in*)result->ai_addr)->sin_addr.s_addr;
+			this->peerPort = htons(peerPort);
+			freeaddrinfo(result);
+
+#ifdef _WIN32
+			SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+			if (s == INVALID_SOCKET)
+				throw(std::runtime_error("Failed to create a UDP socket."));
+			handle = (std::intptr_t)s;
+			u_long nonBlocking = 1;
+			ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+			int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+			if (s < 0)
+				throw(std::runtime_error("Failed to create a UDP socket."));
+			handle = s;
+			fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+			sockaddr_in local = {};
+			local.sin_family = AF_INET;
+			local.sin_addr.s_addr = htonl(INADDR_ANY);
+			local.sin_port = htons(localPort);
+			if (bind(s, (sockaddr*)&local, sizeof(local)) != 0) {
+				closeSocket(handle);
+				throw(std::runtime_error("Failed to bind to port " + std::to_string(localPort) + "."));
+			}
+		}
+
+		UdpLink::~UdpLink() {
+			closeSocket(handle);
+#ifdef _WIN32
+			WSACleanup();
+#endif
+		}
+
+		void UdpLink::send(const std::vector<std::uint8_t>& packet) {
+			sockaddr_in peer = {};
+			peer.sin_family = AF_INET;
+			peer.sin_addr.s_addr = peerAddress;
+			peer.sin_port = peerPort;
+			// A packet that can't be sent is as good as lost, which the other end has to deal with anyway
+			sendto((NativeSocket)handle, (const char*)packet.data(), (int)packet.size(), 0, (sockaddr*)&peer, sizeof(peer));
+		}
+
+		bool UdpLink::receive(std::vector<std::uint8_t>& packet) {
+			packet.resize(maxPacketSize);
+			while (true) {
+				sockaddr_in from = {};
+				socklen_t fromSize = sizeof(from);
+				auto size = recvfrom((NativeSocket)handle, (char*)packet.data(), (int)packet.size(), 0, (sockaddr*)&from, &fromSize);
+				if (size < 0) {
+					// Nothing has arrived, or an error that only means an earlier packet didn't arrive
+					packet.clear();
+					return false;
+				}
+				if (from.sin_addr.s_addr != peerAddress || from.sin_port != peerPort)
+					continue;
+				packet.resize((std::size_t)size);
+				return true;
+			}
+		}
+
+	// LossyLink : public Link
+
+		LossyLink::LossyLink(std::shared_ptr<Link> link, double latency, double jitter, double loss, std::uint64_t seed) :
+			link(link),
+			latency(latency),
+			jitter(jitter),
+			loss(loss),
+			rng(seed),
+			stopwatch(Time::GlobalStopwatch::getInstance())
+		{}
+
+		void LossyLink::flush() {
+			TimePoint now = stopwatch->now();
+			unsigned int w = 0;
+			for (unsigned int r = 0; r < queue.size(); ++r) {
+				if (queue[r].due <= now)
+					link->send(queue[r].packet);
+				else
+					std::swap(queue[w++], queue[r]);
+			}
+			queue.resize(w);
+		}
+
+		void LossyLink::send(const std::vector<std::uint8_t>& packet) {
+			flush();
+			if (rng.chanceOutOf(loss))
+				return;
+			double delay = latency + rng.realFromRange(0.0, jitter);
+			auto due = stopwatch->now() + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(delay));
+			queue.push_back({ due, packet });
+		}
+
+		bool LossyLink::receive(std::vector<std::uint8_t>& packet) {
+			flush();
+			return link->receive(packet);
+		}
+
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "StdAfx.h"
+#include "time.h"
+#include "random.h"
+
+namespace SI {
+	namespace Ctrl {
+
+		// A connection to a single peer over which small packets can be sent and received
+		// Like UDP, packets may be lost, duplicated or arrive out of order, but never arrive corrupted or in part
+		class Link {
+		public:
+			virtual ~Link() {}
+
+			// Send a packet to the peer
+			virtual void send(const std::vector<std::uint8_t>& packet) = 0;
+
+			// Take the next packet that has arrived from the peer into 'packet', reusing its storage
+			// Returns false if no packet has arrived, never blocks
+			virtual bool receive(std::vector<std::uint8_t>& packet) = 0;
+		};
+
+		// A Link over a non-blocking UDP socket, only accepting packets coming from the peer
+		class UdpLink : public Link {
+		private:
+			// The socket, as the platform's socket handle
+			std::intptr_t handle;
+
+			// The peer's IPv4 address and port, in network byte order
+			std::uint32_t peerAddress;
+			std::uint16_t peerPort;
+
+		public:
+			// Bind to the given local port and send to the given host and port
+			// Throws if the socket can't be made or bound, or if the host can't be resolved
+			UdpLink(unsigned short localPort, std::string peerHost, unsigned short peerPort);
+			~UdpLink();
+
+			UdpLink(const UdpLink&) = delete;
+			UdpLink& operator=(const UdpLink&) = delete;
+
+			virtual void send(const std::vector<std::uint8_t>& packet);
+			virtual bool receive(std::vector<std::uint8_t>& packet);
+		};
+
+		// A Link passing packets on to another Link after a delay, and dropping some of them along the way
+		// Simulates a bad connection on a single machine, apply it on both ends to affect both directions
+		class LossyLink : public Link {
+		private:
+			// A packet waiting for its delay to pass
+			struct Delayed {
+				TimePoint due;
+				std::vector<std::uint8_t> packet;
+			};
+
+			// The link packets are passed on to
+			std::shared_ptr<Link> link;
+
+			// The delay of every packet in seconds, plus up to 'jitter' seconds more at random
+			double latency, jitter;
+
+			// The chance of a packet being dropped, out of 1
+			double loss;
+
+			// Decides which packets are dropped and how long they are delayed
+			RNG::RNG rng;
+
+			// The real time clock
+			std::shared_ptr<Time::Stopwatch> stopwatch;
+
+			// The packets that haven't been passed on yet
+			std::vector<Delayed> queue;
+
+			// Pass on every packet whose delay has passed
+			void flush();
+
+		public:
+			LossyLink(std::shared_ptr<Link> link, double latency, double jitter, double loss, std::uint64_t seed = RNG::RNG::randomSeed());
+
+			// Drop the packet or queue it up to be passed on once its delay has passed
+			virtual void send(const std::vector<std::uint8_t>& packet);
+
+			// Pass on the packets that are due, then receive from the wrapped link
+			virtual bool receive(std::vector<std::uint8_t>& packet);
+		};
+
+	}
+}
@@ -5,47 +5,113 @@
 namespace SI {
 
 	namespace Md {
-		Model::Model(double tickPeriod) :
-			stopwatch(std::make_shared<Time::SimStopwatch>()),
-			updateTimer(tickPeriod),
+
+		// Helper functions
+
+		// Get the text shown when picking up a powerup of the given type
+		static TextId pickupText(PowerupType type) {
+			static const std::array<TextId, 5> texts = {{
+				internText("FREEZE!"), internText("SPEED UP!"), internText("FIRE UP!"), internText("SHOT UP!"), internText("DMG UP!")
+			}};
+			return texts[type];
+		}
+
+		Model::Model(double stepLength, unsigned int maxCatchUpSteps, std::string levelDirectory) :
+			Model(stepLength, maxCatchUpSteps, LevelParser(levelDirectory).parseLevels())
+		{}
+
+		Model::Model(double stepLength, unsigned int maxCatchUpSteps, std::vector<std::shared_ptr<Level>> levels) :
+			stepLength(stepLength),
+			maxCatchUpSteps(maxCatchUpSteps),
+			accumulator(0),
+			timeScale(1),
+			clock(std::make_shared<Time::ManualStopwatch>()),
+			playerCount(1),
+			stopwatch(std::make_shared<Time::SimStopwatch>(clock)),
+			currentLevel(0),
+			levels(levels),
 			counter(stopwatch),
-			pauseTimer(0.2f),
-			playerInvincTimer(3.0, true, stopwatch),
-			playerDeadTimer(2.0, true, stopwatch),
-			levelSwitchTimer(3.0, true),
-			currentLevel(0)
+			collisionMode(CollisionMode::bruteForce),
+			collisionGrid(800, 720, 40),
+			enemyShots(0.1, stopwatch),	// Every enemy fires once every 10 seconds on average
+			lives(3),
+			levelSwitchTimer(3.0, true, clock),
+			pauseTimer(0.2f, clock),
+			observersMuted(false)
 		{
-			levelParser = std::unique_ptr<LevelParser>(new LevelParser);
-			enemyCluster = std::unique_ptr<EnemyCluster>(new EnemyCluster(stopwatch));
+			if (stepLength <= 0)
+				throw(std::runtime_error("The model's step length must be positive."));
+
+			enemyCluster = std::unique_ptr<EnemyCluster>(new EnemyCluster(entities, stopwatch));
+			for (unsigned int p = 0; p < maxPlayers; ++p) {
+				players[p] = std::unique_ptr<Player>(new Player(stopwatch));
+				playerInvincTimers.emplace_back(3.0, true, stopwatch);
+				playerDeadTimers.emplace_back(2.0, true, stopwatch);
+			}
+
+			if (levels.empty())
+				throw(std::runtime_error("The model needs at least one level."));
+		}
+
+		void Model::seed(std::uint64_t seed) {
+			rng.seed(seed);
+		}
 
-			levels = levelParser->parseLevels();
+		void Model::setPlayerCount(unsigned int playerCount) {
+			if (playerCount < 1 || playerCount > maxPlayers)
+				throw(std::runtime_error("A game can't be played by " + std::to_string(playerCount) + " players."));
+			this->playerCount = playerCount;
 		}
 
-		void Model::reset()	{
+		unsigned int Model::getPlayerCount() const {
+			return playerCount;
+		}
+
+		void Model::reset(unsigned int startLevel)	{
+			if (startLevel >= levels.size())
+				throw(std::runtime_error("There is no level " + std::to_string(startLevel) + "."));
+			for (unsigned int p = 0; p < playerCount; ++p)
+				if (!inputSources[p])
+					throw(std::runtime_error("Player " + std::to_string(p + 1) + " has no input source."));
+
 			levelSwitchTimer.forceFalse();
-			playerDeadTimer.forceFalse();
-			playerInvincTimer.forceFalse();
+			for (unsigned int p = 0; p < playerCount; ++p) {
+				playerDeadTimers[p].forceFalse();
+				playerInvincTimers[p].forceFalse();
+				players[p] = std::unique_ptr<Player>(new Player(stopwatch));
+			}
 			updateState(ModelState::running);
 
-			player = std::make_shared<Md::Player>(50, 640, stopwatch);
 			updateLives(3);
 
-			currentLevel = 0;
+			currentLevel = startLevel;
 			loadLevel();
 		}
 
-		void Model::registerView(std::shared_ptr<Vw::View> view) {
-			observers.push_back(view->getObserver());
+		void Model::registerObserver(std::shared_ptr<ModelObserver> observer) {
+			observer->updateEvents(events);
+			if (observersMuted) {
+				mutedObservers.push_back(observer);
+				return;
+			}
+			observers.push_back(observer);
+			updateEntities();
+		}
+
+		void Model::registerInputSource(std::shared_ptr<Ctrl::InputSource> inputSource, unsigned int player) {
+			if (player >= maxPlayers)
+				throw(std::runtime_error("There is no player " + std::to_string(player + 1) + "."));
+			inputSources[player] = inputSource;
 		}
 
-		void Model::registerController(std::shared_ptr<Ctrl::Controller> controller) {
-			this->controller = controller;
+		void Model::setCollisionMode(CollisionMode mode){
+			collisionMode = mode;
 		}
 
 		void Model::clearEntities(){
 			entities.clear();
-			for(auto& observer : observers)
-				observer->clearEntities();
+			collisionGrid.clear();
+			enemyShots.clear();
 		}
 
 		void Model::updateState(ModelState state){
@@ -55,16 +121,23 @@ namespace SI {
 		}
 
 		void Model::updateLives(int lives){
-			player->setHealth(lives);
+			this->lives = lives;
+			for (unsigned int p = 0; p < playerCount; ++p) {
+				if (!entities.isValid(playerHandles[p]))
+					continue;
+				unsigned int i = entities.getIndex(playerHandles[p]);
+				entities[EntityType::player].health[i] = lives;
+			}
 			for (auto& observer : observers)
 				observer->updateLives(lives);
 		}
 
 		void Model::updatePlayerState(){
-			for (auto& observer : observers) {
-				observer->updatePlayerDead(playerDeadTimer());
-				observer->updatePlayerInvinc(playerInvincTimer());
-			}
+			for (auto& observer : observers)
+				for (unsigned int p = 0; p < playerCount; ++p) {
+					observer->updatePlayerDead(p, playerDeadTimers[p]());
+					observer->updatePlayerInvinc(p, playerInvincTimers[p]());
+				}
 		}
 
 		void Model::updateLevelName(){
@@ -91,14 +164,35 @@ namespace SI {
 			enemyCluster->setSpeed(levels[currentLevel]->getSpeed(), levels[currentLevel]->getSpeedInc());
 
 			updateLevelName();
-			addEntity(player);
-			playerSpawn();
-			playerDeadTimer.forceFalse();
-			playerInvincTimer.forceFalse();
+			reserveEntities();
+			for (unsigned int p = 0; p < playerCount; ++p) {
+				playerHandles[p] = addEntity(EntityType::player, playerSpawnX(p), 640, lives);
+				playerSpawn(p);
+				playerDeadTimers[p].forceFalse();
+				playerInvincTimers[p].forceFalse();
+			}
+
+			levels[currentLevel]->makeEntities(*this);
+		}
 
-			auto newEntities = levels[currentLevel]->makeEntities();
-			for (auto& e : newEntities)
-				addEntity(e);
+		void Model::reserveEntities(){
+			const auto& level = levels[currentLevel];
+			unsigned int enemies = level->count(smallEnemy) + level->count(bigEnemy);
+
+			entities.reserve(EntityType::player, playerCount);
+			entities.reserve(smallEnemy, level->count(smallEnemy));
+			entities.reserve(bigEnemy, level->count(bigEnemy));
+			entities.reserve(barrier, level->count(barrier));
+			// Bullets and powerups depend on how the level plays out, leave plenty of room
+			entities.reserve(playerBullet, 64);
+			entities.reserve(enemyBullet, std::max(64u, enemies));
+			entities.reserve(powerup, std::max(16u, enemies / 2));
+
+			unsigned int total = 0;
+			for (unsigned int t = 0; t < entityTypeCount; ++t)
+				total += entities[(EntityType)t].capacity;
+			entitySnapshot.reserve(total);
+			enemyShots.reserve(enemies);
 		}
 
 		void Model::completeLevel(){
@@ -119,16 +213,75 @@ namespace SI {
 		}
 
 		void Model::tick() {
-			
-			if (!updateTimer())	// Cancel the tick if it's too soon
-				return;
-			
-				// dt = time since last tick in seconds
-			double dt = stopwatch->tick();
+			for (unsigned int steps = dueSteps(); steps; --steps)
+				step();
+		}
+
+		unsigned int Model::dueSteps() {
+			return dueSteps(Time::GlobalStopwatch::getInstance()->now());
+		}
+
+		unsigned int Model::dueSteps(TimePoint now) {
+			if (lastTick.time_since_epoch().count())
+				accumulator += Time::nanoToSeconds(now - lastTick) * timeScale;
+			lastTick = now;
+
+				// The passed time is simulated in exact steps, carrying the remainder over to the next tick
+			unsigned int steps = 0;
+			while (accumulator >= stepLength) {
+				if (steps == maxCatchUpSteps) {
+					// Drop the time we can't catch up on, rather than spending ever longer ticks trying to
+					accumulator = std::fmod(accumulator, stepLength);
+					break;
+				}
+				accumulator -= stepLength;
+				++steps;
+			}
+			return steps;
+		}
+
+		double Model::getStepLength() const {
+			return stepLength;
+		}
+
+		TimePoint Model::nextStepTime() const {
+			double wait = std::max(stepLength - accumulator, 0.0) / timeScale;
+			return lastTick + std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<double>(wait));
+		}
+
+		TimePoint Model::lastStepTime() const {
+			double since = accumulator / timeScale;
+			return lastTick - std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<double>(since));
+		}
+
+		double Model::getStepPeriod() const {
+			return stepLength / timeScale;
+		}
+
+		void Model::setTimeScale(double timeScale) {
+			this->timeScale = timeScale;
+		}
+
+		void Model::step() {
+			simulateStep();
+			updateEntities();
+			for (auto& observer : observers)
+				observer->updateEvents(events);
+		}
+
+		void Model::simulateStep() {
+			clock->advance(stepLength);
+
+				// dt = the step length, or 0 if the simulation is paused
+			double dt = stopwatch->isPaused() ? 0 : stepLength;
+			stopwatch->tick();
 
-				// read inputs based off dt
-			if(state != ModelState::levelSwitch)
-				tickInput(dt);
+				// read inputs based off dt, the input sources are asked every step so that recorded input lines up with the steps
+			std::array<Ctrl::InputState, maxPlayers> inputs;
+			for (unsigned int p = 0; p < playerCount; ++p)
+				inputs[p] = inputSources[p]->getInput();
+			for (unsigned int p = 0; p < playerCount && state != ModelState::levelSwitch; ++p)
+				tickInput(dt, p, inputs[p]);
 
 				// If we're in the LevelComplete state, check if we can leave the state, otherwise don't do anything
 			if (state == ModelState::levelSwitch && !levelSwitchTimer()) {
@@ -144,33 +297,30 @@ namespace SI {
 				// Update the payload on time-related business
 			updatePlayerState();
 
-				// Separate the Entities
-			std::vector<std::shared_ptr<Bullet>> bullets;
-			std::vector<std::shared_ptr<Enemy>> enemies;
-			std::vector<std::shared_ptr<Barrier>> barriers;
-			std::vector<std::shared_ptr<Powerup>> powerups;
-			
-			for (auto& entity : entities) {
-				if (const auto& e = std::dynamic_pointer_cast<Bullet>(entity))
-					bullets.push_back(e);
-				if (const auto& e = std::dynamic_pointer_cast<Enemy>(entity))
-					enemies.push_back(e);
-				if (const auto& e = std::dynamic_pointer_cast<Barrier>(entity))
-					barriers.push_back(e);
-				if (const auto& e = std::dynamic_pointer_cast<Powerup>(entity))
-					powerups.push_back(e);
-			}
-			
+				// Sort the barriers and enemies into the broadphase grid
+			if (collisionMode == CollisionMode::uniformGrid)
+				for (EntityType type : { barrier, smallEnemy, bigEnemy })
+					collisionGrid.insert(type, entities[type]);
+
 				// Tick all entities appropriately
-			
-			for (auto& e : bullets)
-				tickBullet(dt, e, enemies, barriers);
+				// Entities spawned during this tick are only ticked starting next tick
+			for (EntityType type : { playerBullet, enemyBullet })
+				for (unsigned int i = 0, n = entities[type].count(); i < n; ++i)
+					if (!entities[type].isRemoved(i))
+						tickBullet(dt, type, i);
 
-			for (auto& e : enemies)
-				tickEnemy(dt, e, barriers);
+			tickEnemyShots();
+			for (EntityType type : { smallEnemy, bigEnemy })
+				for (unsigned int i = 0, n = entities[type].count(); i < n; ++i)
+					if (!entities[type].isRemoved(i))
+						tickEnemy(type, i);
 
-			for (auto& e : powerups)
-				tickPowerup(dt, e);
+			for (unsigned int i = 0, n = entities[powerup].count(); i < n; ++i)
+				if (!entities[powerup].isRemoved(i))
+					tickPowerup(dt, i);
+
+			// Remove everything that died during this tick
+			flushDeletions();
 
 			// Tick the enemy cluster
 			enemyCluster->tick(dt);
@@ -186,24 +336,109 @@ namespace SI {
 
 		}
 
-		void Model::tickInput(double dt){
-			std::vector<Ctrl::Input> inputs = controller->getInput();
-			for (Ctrl::Input input : inputs) {
-				switch (input){
+		void Model::saveSnapshot(Snapshot& out) const {
+			out.clear();
+			clock->save(out);
+			stopwatch->save(out);
+			out.write(currentLevel);
+			counter.save(out);
+			entities.save(out);
+			enemyCluster->save(out);
+			enemyShots.save(out);
+			rng.save(out);
+			for (unsigned int p = 0; p < playerCount; ++p) {
+				players[p]->save(out);
+				out.write(playerHandles[p]);
+				playerInvincTimers[p].save(out);
+				playerDeadTimers[p].save(out);
+			}
+			out.write(lives);
+			out.write(state);
+			levelSwitchTimer.save(out);
+			pauseTimer.save(out);
+		}
+
+		void Model::loadSnapshot(const Snapshot& in, bool updateObservers) {
+			Snapshot::Reader reader(in);
+			clock->load(reader);
+			stopwatch->load(reader);
+			reader.read(currentLevel);
+			if (currentLevel >= levels.size())
+				throw(std::runtime_error("The snapshot is of a model playing different levels."));
+			counter.load(reader);
+			entities.load(reader);
+			enemyCluster->load(reader);
+			enemyShots.load(reader);
+			rng.load(reader);
+			for (unsigned int p = 0; p < playerCount; ++p) {
+				players[p]->load(reader);
+				reader.read(playerHandles[p]);
+				playerInvincTimers[p].load(reader);
+				playerDeadTimers[p].load(reader);
+			}
+			reader.read(lives);
+			reader.read(state);
+			levelSwitchTimer.load(reader);
+			pauseTimer.load(reader);
+			if (!reader.atEnd())
+				throw(std::runtime_error("The snapshot holds more than a model's state."));
+
+			if (updateObservers)
+				this->updateObservers();
+		}
+
+		void Model::updateEntities() {
+			if (observers.empty())
+				return;
+			entities.observe(entitySnapshot);
+			for (auto& observer : observers) {
+				observer->updateEntities(entitySnapshot);
+				observer->updateEntityCount(entities.count());
+			}
+		}
+
+		void Model::updateObservers() {
+			updateEntities();
+			for (auto& observer : observers) {
+				observer->updateState(state);
+				observer->updateLives(lives);
+			}
+			updateLevelName();
+			updatePlayerState();
+			updateSecondsPassed();
+		}
+
+		void Model::muteObservers(bool muted) {
+			if (muted == observersMuted)
+				return;
+			observersMuted = muted;
+			if (muted) {
+				mutedObservers.swap(observers);
+				return;
+			}
+			observers.swap(mutedObservers);
+			updateObservers();
+		}
+
+		void Model::tickInput(double dt, unsigned int p, Ctrl::InputState inputs){
+			for (unsigned int i = 0; i <= Ctrl::MAX_INPUTNUM; ++i) {
+				if (!inputs[i])
+					continue;
+				switch (Ctrl::Input(i)){
 
 				case Ctrl::shoot:
-					if (state == ModelState::running && !playerDeadTimer())
-						player->shoot();
+					if (state == ModelState::running && !playerDeadTimers[p]())
+						playerShoot(p);
 					break;
 
 				case Ctrl::left:
-					if (state == ModelState::running && !playerDeadTimer())
-						player->moveLeft(dt);
+					if (state == ModelState::running && !playerDeadTimers[p]())
+						playerMove(p, -dt * players[p]->getSpeed());
 					break;
 
 				case Ctrl::right:
-					if (state == ModelState::running && !playerDeadTimer())
-						player->moveRight(dt);
+					if (state == ModelState::running && !playerDeadTimers[p]())
+						playerMove(p, dt * players[p]->getSpeed());
 					break;
 
 				case Ctrl::pause:
@@ -231,125 +466,328 @@ namespace SI {
 			}
 		}
 
-		void Model::tickBullet(double dt, std::shared_ptr<Bullet> e, std::vector<std::shared_ptr<Enemy>> enemies, std::vector<std::shared_ptr<Barrier>> barriers){
-			e->tick(dt);
-			for (auto& barrier : barriers)
-				if (e->hit(barrier))
-					e->hurt(barrier);
-
-			if (const auto& p = std::dynamic_pointer_cast<PlayerBullet>(e)) {
-				for (auto& enemy : enemies)
-					if (p->hit(enemy))
-						p->hurt(enemy);
-				
-			} else if (const auto& p = std::dynamic_pointer_cast<EnemyBullet>(e)) {
-				if (p->hit(player) && !playerDeadTimer()) {
-					addEvent(Event(bulletHit, e->getX(), e->getY()));
-					deleteEntity(e);
-					playerHit();
+		void Model::findCandidates(EntityType type, double x, double y, float size){
+			const EntityArray& others = entities[type];
+			if (collisionMode == CollisionMode::uniformGrid) {
+				collisionGrid.query(type, x, y, size, candidates);
+				candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+					[&others](unsigned int j) { return others.isRemoved(j); }), candidates.end());
+				return;
+			}
+			// Brute force: every entity is a candidate
+			candidates.clear();
+			for (unsigned int j = 0; j < others.count(); ++j)
+				if (!others.isRemoved(j))
+					candidates.push_back(j);
+		}
+
+		void Model::sweepCandidates(EntityType type, double x0, double y0, double x1, double y1, float size){
+			EntityArray& others = entities[type];
+			// A circle around the middle of the path, large enough to contain all of it
+			double reach = size + std::sqrt((x1 - x0)*(x1 - x0) + (y1 - y0)*(y1 - y0)) / 2;
+			findCandidates(type, (x0 + x1) / 2, (y0 + y1) / 2, (float)reach);
+
+			double t;
+			for (unsigned int j : candidates)
+				if (sweep(x0, y0, x1, y1, size, others.worldX(j), others.worldY(j), others.size[j], t))
+					collisions.push_back(Collision(t, type, j));
+		}
+
+		void Model::tickBullet(double dt, EntityType type, unsigned int i){
+			EntityArray& bullets = entities[type];
+			double x0 = bullets.x[i], y0 = bullets.y[i];
+			double x1 = x0 + bullets.xvel[i] * dt;
+			double y1 = y0 + bullets.yvel[i] * dt;
+			bullets.xvel[i] += bullets.xacc[i] * dt;
+			bullets.yvel[i] += bullets.yacc[i] * dt;
+
+			// Find everything along the bullet's path, so fast bullets can't pass through anything between ticks
+			collisions.clear();
+			sweepCandidates(barrier, x0, y0, x1, y1, bullets.size[i]);
+			if (type == playerBullet) {
+				sweepCandidates(smallEnemy, x0, y0, x1, y1, bullets.size[i]);
+				sweepCandidates(bigEnemy, x0, y0, x1, y1, bullets.size[i]);
+			} else {
+				EntityArray& playerEntities = entities[EntityType::player];
+				for (unsigned int p = 0; p < playerCount; ++p) {
+					if (playerDeadTimers[p]())
+						continue;
+					unsigned int j = entities.getIndex(playerHandles[p]);
+					double t;
+					if (sweep(x0, y0, x1, y1, bullets.size[i], playerEntities.x[j], playerEntities.y[j], playerEntities.size[j], t))
+						collisions.push_back(Collision(t, EntityType::player, j));
 				}
 			}
-			if (e->getX() < 0 || e->getY() > 720 || e->isDead())
-				deleteEntity(e);
+			std::sort(collisions.begin(), collisions.end(), [](const Collision& a, const Collision& b) {
+				if (a.t != b.t)
+					return a.t < b.t;
+				return a.type != b.type ? a.type < b.type : a.index < b.index;
+			});
+
+			// Resolve the collisions in the order they happen, until the bullet is spent
+			for (unsigned int k = 0; k < collisions.size() && !bullets.isDead(i); ++k) {
+				Collision& c = collisions[k];
+				bullets.x[i] = x0 + (x1 - x0) * c.t;
+				bullets.y[i] = y0 + (y1 - y0) * c.t;
+
+				switch (c.type) {
+				case barrier:
+					bulletHurtBarrier(type, i, c.index);
+					break;
+				case smallEnemy:
+				case bigEnemy:
+					bulletHurtEnemy(i, c.type, c.index);
+					break;
+				case EntityType::player:
+					addEvent(Event(bulletHit, bullets.x[i], bullets.y[i]));
+					bullets.health[i] = 0;
+					for (unsigned int p = 0; p < playerCount; ++p)
+						if (entities.getIndex(playerHandles[p]) == c.index)
+							playerHit(p);
+					break;
+				default:
+					break;
+				}
+			}
+
+			if (!bullets.isDead(i)) {
+				bullets.x[i] = x1;
+				bullets.y[i] = y1;
+			}
+
+			if (bullets.x[i] < 0 || bullets.y[i] < 0 || bullets.y[i] > 720 || bullets.isDead(i))
+				deleteEntity(type, i);
 		}
 		
-		void Model::tickEnemy(double dt, std::shared_ptr<Enemy> e, std::vector<std::shared_ptr<Barrier>> barriers) {
-			e->tick(dt);
-			for (auto& barrier : barriers) {
-				if (e->hit(barrier)) {
-					e->hurt(barrier);
-					if (e->isDead()) {
-						deleteEntity(e);
-						e->destroyEvent();
+		void Model::tickEnemyShots() {
+			ShotSchedule::Shot shot;
+			while (enemyShots.popDue(shot)) {
+				// The shots of enemies destroyed since they were scheduled are dropped, also when their slot has been reused by another type
+				if (!entities.isValid(shot.handle) || entities.getType(shot.handle) != shot.type)
+					continue;
+				unsigned int i = entities.getIndex(shot.handle);
+				if (entities[shot.type].isRemoved(i))
+					continue;
+				enemyShoot(shot.type, i);
+				enemyShots.scheduleAfter(shot, rng);
+			}
+		}
+
+		void Model::tickEnemy(EntityType type, unsigned int i) {
+			EntityArray& enemies = entities[type];
+			EntityArray& barriers = entities[barrier];
+			double x = enemies.worldX(i), y = enemies.worldY(i);
+			findCandidates(barrier, x, y, enemies.size[i]);
+			for (unsigned int j : candidates) {
+				if (hit(x, y, enemies.size[i], barriers.x[j], barriers.y[j], barriers.size[j])) {
+					enemyHurtBarrier(type, i, j);
+					if (enemies.isDead(i)) {
+						destroyEnemy(type, i);
+						return;
 					}
 				}
 			}
 		}
 
-		void Model::tickPowerup(double dt, std::shared_ptr<Powerup> e){
-			e->tick(dt);
-			if (e->hit(player)) {
-				deleteEntity(e);
-				switch (e->getPowerupType()) {
+		void Model::tickPowerup(double dt, unsigned int i){
+			EntityArray& powerups = entities[powerup];
+			powerups.y[i] += powerups.yvel[i] * dt;
+			powerups.yvel[i] += powerups.yacc[i] * dt;
+
+			double x = powerups.x[i];
+			double y = powerups.y[i];
+
+			// The first player to touch the powerup picks it up
+			EntityArray& playerEntities = entities[EntityType::player];
+			for (unsigned int p = 0; p < playerCount; ++p) {
+				unsigned int j = entities.getIndex(playerHandles[p]);
+				if (!hit(x, y, powerups.size[i], playerEntities.x[j], playerEntities.y[j], playerEntities.size[j]))
+					continue;
+				Player* player = players[p].get();
+				deleteEntity(powerup, i);
+				PowerupType type = randomPowerupType(rng);
+				switch (type) {
 				case speedUp:
 					player->speedUp();
-					addEvent(Event(pickup, e->getX(), e->getY(), "SPEED UP!"));
 					break;
 				case bulletSpeedUp:
 					player->bulletSpeedUp();
-					addEvent(Event(pickup, e->getX(), e->getY(), "SHOT UP!"));
 					break;
 				case fireRateUp:
 					player->fireRateUp();
-					addEvent(Event(pickup, e->getX(), e->getY(), "FIRE UP!"));
 					break;
 				case damageUp:
 					player->damageUp();
-					addEvent(Event(pickup, e->getX(), e->getY(), "DMG UP!"));
 					break;
 				case slowdown:
 					enemyCluster->freeze();
-					addEvent(Event(pickup, e->getX(), e->getY(), "FREEZE!"));
 					break;
 				}
+				addEvent(Event(pickup, x, y, pickupText(type)));
+				return;
 			}
 			// Destroy the powerup if it falls off the bottom of the screen
-			if (e->getY() > 720.0)
-				deleteEntity(e);
+			if (y > 720.0)
+				deleteEntity(powerup, i);
 		}
 
-		void Model::addEvent(const Event& e){
-			for(auto& observer : observers)
-				observer->addEvent(e);
+		void Model::bulletHurtBarrier(EntityType type, unsigned int i, unsigned int j){
+			EntityArray& bullets = entities[type];
+			EntityArray& barriers = entities[barrier];
+			addEvent(Event(bulletHit, bullets.x[i], bullets.y[i]));
+			addEvent(Event(barrierHit, barriers.x[j], barriers.y[j]));
+
+			int min = std::min(bullets.health[i], barriers.health[j]);
+			bullets.health[i] -= min;
+			barriers.health[j] -= min;
+
+			if (barriers.isDead(j))
+				destroyBarrier(j);
 		}
 
-		void Model::addEntity(std::shared_ptr<Entity> entity) {
+		void Model::bulletHurtEnemy(unsigned int i, EntityType type, unsigned int j){
+			EntityArray& bullets = entities[playerBullet];
+			EntityArray& enemies = entities[type];
+			addEvent(Event(bulletHit, bullets.x[i], bullets.y[i]));
+			addEvent(Event(enemyHit, enemies.worldX(j), enemies.worldY(j)));
 
-			entity->registerModel(this);
-			entities.push_back(entity);
-			if (const auto& e = std::dynamic_pointer_cast<Enemy>(entity))
-				enemyCluster->addEnemy(e);
+			int min = std::min(bullets.health[i], enemies.health[j]);
+			bullets.health[i] -= min;
+			enemies.health[j] -= min;
 
-			for (auto& observer : observers) {
-				auto pe = observer->addEntity();
-				entity->registerObserver(pe);
-				observer->updateEntityCount(entities.size());
+			if (enemies.isDead(j))
+				destroyEnemy(type, j);
+		}
+
+		void Model::enemyHurtBarrier(EntityType type, unsigned int i, unsigned int j){
+			EntityArray& enemies = entities[type];
+			EntityArray& barriers = entities[barrier];
+			// create an explosion between the barrier and alien
+			addEvent(Event(bulletHit, (barriers.x[j] + enemies.worldX(i)) / 2, (barriers.y[j] + enemies.worldY(i)) / 2));
+
+			if (type == bigEnemy) {
+				// Straight-up destroy the barrier without taking damage
+				destroyBarrier(j);
+				return;
+			}
+
+			int min = std::min(enemies.health[i], 1 + barriers.health[j] / 2);	// Take at least 1 damage, + 1 damage for every 2 hp the barrier has
+			enemies.health[i] -= min;
+
+			barriers.health[j] -= min * 2;
+			if (barriers.isDead(j))
+				destroyBarrier(j);
+		}
+
+		void Model::enemyShoot(EntityType type, unsigned int i){
+			EntityArray& enemies = entities[type];
+			if (type == smallEnemy)		// A small and fast bullet
+				addEntity(enemyBullet, enemies.worldX(i), enemies.worldY(i), 1, rng.intFromRange(-30, 30), 300);
+			else						// A large and slow bullet
+				addEntity(enemyBullet, enemies.worldX(i), enemies.worldY(i), 2, rng.intFromRange(-20, 20), 200);
+			addEvent(Event(EventType::enemyShotFired));
+		}
+
+		void Model::destroyEnemy(EntityType type, unsigned int i){
+			EntityArray& enemies = entities[type];
+			double x = enemies.worldX(i);
+			double y = enemies.worldY(i);
+			if (!deleteEntity(type, i))
+				return;
+			enemyCluster->enemyRemoved(type, i);
+
+			if (type == smallEnemy) {
+				addEvent(Event(smallEnemyDestroyed, x, y));
+				if (rng.chanceOutOf(1, 8))
+					addEntity(powerup, x, y, 1, 0, 100.0, 0, 50.0);
+			} else {
+				addEvent(Event(bigEnemyDestroyed, x, y));
+				if (rng.chanceOutOf(1, 2))
+					addEntity(powerup, x, y, 1, 0, 100.0, 0, 50.0);
+			}
+		}
+
+		void Model::destroyBarrier(unsigned int i){
+			EntityArray& barriers = entities[barrier];
+			if (deleteEntity(barrier, i))
+				addEvent(Event(barrierDestroyed, barriers.x[i], barriers.y[i]));
+		}
+
+		void Model::addEvent(const Event& e){
+			// Events that happen while the observers are muted are lost
+			if (!observers.empty())
+				events.push(e);
+		}
+
+		EntityHandle Model::addEntity(EntityType type, double x, double y, int health, double xvel, double yvel, double xacc, double yacc) {
+			EntityHandle handle = entities.add(type, x, y, entitySize(type, health), health, xvel, yvel, xacc, yacc);
+			unsigned int i = entities.getIndex(handle);
+			if (type == smallEnemy || type == bigEnemy) {
+				enemyCluster->enemyAdded(type, i);
+				enemyShots.schedule(handle, type, rng);
 			}
+			return handle;
 		}
 
-		void Model::deleteEntity(std::shared_ptr<Entity> entity){
+		bool Model::deleteEntity(EntityType type, unsigned int i){
+			return entities[type].remove(i);
+		}
 
-			entities.erase(std::remove(entities.begin(), entities.end(), entity), entities.end());
-			if (const auto& e = std::dynamic_pointer_cast<Enemy>(entity))
-				enemyCluster->deleteEnemy(e);
+		void Model::flushDeletions(){
+			entities.compact();
+		}
 
-			for (unsigned int i = 0; i < observers.size(); ++i) {
-				observers[i]->deleteEntity(entity->getObservers()[i]);
-				observers[i]->updateEntityCount(entities.size());
+		void Model::playerShoot(unsigned int player){
+			if (players[player]->fire()) {
+				EntityArray& playerEntities = entities[EntityType::player];
+				unsigned int p = entities.getIndex(playerHandles[player]);
+				addEntity(playerBullet, playerEntities.x[p], playerEntities.y[p], players[player]->getBulletDmg(), 0, -players[player]->getBulletSpeed(), 0, -200);
+				addEvent(Event(friendlyShotFired));
 			}
 		}
 
-		void Model::playerHit(){
-			addEvent(Event(EventType::friendlyHit, player->getX(), player->getY()));
+		void Model::playerMove(unsigned int player, double dx){
+			EntityArray& playerEntities = entities[EntityType::player];
+			unsigned int p = entities.getIndex(playerHandles[player]);
+			if (dx < 0 && playerEntities.x[p] < 50) {
+				playerEntities.x[p] = 50.0;
+				return;
+			}
+			if (dx > 0 && playerEntities.x[p] > 750) {
+				playerEntities.x[p] = 750.0;
+				return;
+			}
+			playerEntities.x[p] += dx;
+		}
+
+		void Model::playerHit(unsigned int player){
+			EntityArray& playerEntities = entities[EntityType::player];
+			unsigned int p = entities.getIndex(playerHandles[player]);
+			addEvent(Event(EventType::friendlyHit, playerEntities.x[p], playerEntities.y[p]));
 			
 			// Don't do anything if the player is invincible
-			if (playerInvincTimer())
+			if (playerInvincTimers[player]())
 				return;
 
-			updateLives(player->getHealth() - 1);
-			if (player->isDead()) {
+			updateLives(lives - 1);
+			if (lives <= 0) {
 				gameOver();
 			}
 			else
-				playerSpawn();
+				playerSpawn(player);
+		}
+
+		void Model::playerSpawn(unsigned int player) {
+			EntityArray& playerEntities = entities[EntityType::player];
+			unsigned int p = entities.getIndex(playerHandles[player]);
+			playerEntities.x[p] = playerSpawnX(player);
+			players[player]->resetPowerups();
+			playerDeadTimers[player].reset();
+			playerInvincTimers[player].reset();
 		}
 
-		void Model::playerSpawn() {
-			player->setX(400);
-			player->resetPowerups();
-			player->updatePosition();
-			playerDeadTimer.reset();
-			playerInvincTimer.reset();
+		double Model::playerSpawnX(unsigned int player) const {
+			return 400.0 + 200.0 * player - 100.0 * (playerCount - 1);
 		}
 
 		void Model::gameOver() {
@@ -4,28 +4,19 @@
 #include "level.h"
 #include "observer.h"
 #include "entity.h"
-#include "view.h"
-#include "controller.h"
+#include "store.h"
+#include "collision.h"
+#include "schedule.h"
+#include "snapshot.h"
+#include "input.h"
 #include "time.h"
 #include "random.h"
 
 namespace SI {
 
-	// Declare classes to resolve dependencies
-	namespace Vw {
-		class View;
-	}
-
 	namespace Md {
-		class Entity;
 		class Player;
-		class Enemy;
 		class EnemyCluster;
-		class Barrier;
-		class Bullet;
-		class FriendlyBullet;
-		class EnemyBullet;
-		class Powerup;
 
 		class LevelParser;
 		class Level;
@@ -35,19 +26,34 @@ namespace SI {
 
 		private:
 				// Various:
-			// A timer that determines the minimum time between ticks
-			Time::BinaryRepeatTimer updateTimer;
+			// The length of a single simulation step in seconds
+			const double stepLength;
+
+			// The maximum number of steps a single tick may take to catch up with real time
+			const unsigned int maxCatchUpSteps;
+
+			// The amount of real time that has passed but hasn't been simulated yet
+			double accumulator;
+
+			// The real time point of the last tick
+			TimePoint lastTick;
+
+			// How much faster than real time the simulation runs when ticked
+			double timeScale;
+
+			// The stopwatch advanced by exactly stepLength every step, regardless of pausedness
+			std::shared_ptr<Time::ManualStopwatch> clock;
 
-			// The controller
-			std::shared_ptr<Ctrl::Controller> controller;
+			// The number of players playing the game
+			unsigned int playerCount;
+
+			// The sources of every player's input
+			std::array<std::shared_ptr<Ctrl::InputSource>, maxPlayers> inputSources;
 			
-			// The stopwatch used as a basis for the simulation, can be paused
+			// The stopwatch used as a basis for the simulation, based on the clock, can be paused
 			std::shared_ptr<Time::SimStopwatch> stopwatch;
 			
 				// Level related:
-			// Parses levels
-			std::unique_ptr<LevelParser> levelParser;
-
 			// Index of the current level
 			unsigned int currentLevel;
 
@@ -58,21 +64,49 @@ namespace SI {
 			Time::Counter counter;
 
 				// Entity related:
-			// The entities handled by the model
-			std::vector<std::shared_ptr<Entity>> entities;
+			// The entities handled by the model, stored in contiguous arrays per EntityType
+			EntityStore entities;
 
 			// A cluster of enemies
 			std::unique_ptr<EnemyCluster> enemyCluster;
 
+			// The way in which colliding pairs of entities are found
+			CollisionMode collisionMode;
+
+			// A broadphase grid containing the barriers and enemies, rebuilt every tick
+			// Indices stay valid throughout the tick since deleted entities are only compacted at the end
+			CollisionGrid collisionGrid;
+
+			// The indices of the entities that might collide with the entity currently being ticked
+			std::vector<unsigned int> candidates;
+
+			// The collisions along the path of the bullet currently being ticked
+			std::vector<Collision> collisions;
+
+			// The snapshot of every entity handed to the observers at the end of every step, its storage reused every step
+			std::vector<EntityObserver> entitySnapshot;
+
+			// The model's own RNG, so that a game can be reproduced from its seed
+			RNG::RNG rng;
+
+			// The moments at which the enemies fire their next shots
+			ShotSchedule enemyShots;
+
 				// Player related:
-			// An additional pointer to the player entity
-			std::shared_ptr<Player> player;
+			// Every player's stats, the player entities themselves are the entities of type EntityType::player
+			std::array<std::unique_ptr<Player>, maxPlayers> players;
+
+			// The handles of the player entities
+			std::array<EntityHandle, maxPlayers> playerHandles;
+
+			// The number of lives left, shared between the players
+			int lives;
 
-			// A timer that determines if the player is invincible
-			Time::WithinPeriodTimer playerInvincTimer;
+			// Timers that determine if the players are invincible
+			std::vector<Time::WithinPeriodTimer> playerInvincTimers;
 
-			// A timer that determines if the player is dead
-			Time::WithinPeriodTimer playerDeadTimer;
+			// Timers that determine if the players are dead
+			std::vector<Time::WithinPeriodTimer> playerDeadTimers;
 
 				// State related:
 			// The current state of the player/model
@@ -87,15 +121,34 @@ namespace SI {
 			// The model's observers
 			std::vector<std::shared_ptr<ModelObserver>> observers;
 
+			// Whether or not the observers are muted, and the observers put aside in the meantime
+			bool observersMuted;
+			std::vector<std::shared_ptr<ModelObserver>> mutedObservers;
+
+			// The latest events, written once and read by every observer
+			EventRing events;
+
 		public:
-			Model(double tickPeriod = 0);
+			Model(double stepLength = 1.0 / 120.0, unsigned int maxCatchUpSteps = 8, std::string levelDirectory = "Assets/levels/");
+
+			// Create a model playing already parsed levels, which may be shared between models
+			Model(double stepLength, unsigned int maxCatchUpSteps, std::vector<std::shared_ptr<Level>> levels);
 
-			// Reset the model to its most basic state
+			// Seed the model's RNG, reset() leaves the RNG as it is
+			void seed(std::uint64_t seed);
+
+			// Set the number of players playing the game, takes effect on the next reset()
+			void setPlayerCount(unsigned int playerCount);
+
+			// Get the number of players playing the game
+			unsigned int getPlayerCount() const;
+
+			// Reset the model to its most basic state, starting at the given level
 			// Has to be called at least once before the model can be used
-			void reset();
+			void reset(unsigned int startLevel = 0);
 
-			// Register a view
-			void registerView(std::shared_ptr<Vw::View> view);
+			// Register an observer to keep updated
+			void registerObserver(std::shared_ptr<ModelObserver> observer);
 
 			// Update the observers on specific state changes
 			void updateState(ModelState state);
@@ -104,8 +157,11 @@ namespace SI {
 			void updateLevelName();
 			void updateSecondsPassed();
 
-			// Register the controller
-			void registerController(std::shared_ptr<Ctrl::Controller> controller);
+			// Set the way in which colliding pairs of entities are found, testing every pair by default
+			void setCollisionMode(CollisionMode mode);
+
+			// Register the source of a player's input, every player needs one
+			void registerInputSource(std::shared_ptr<Ctrl::InputSource> inputSource, unsigned int player = 0);
 
 			// Remove all entities
 			void clearEntities();
@@ -116,42 +172,135 @@ namespace SI {
 			// Load the current level
 			void loadLevel();
 
+			// Make room for every entity the current level could need, so that playing it doesn't allocate
+			void reserveEntities();
+
 			// Complete the current level and move on to the next, or win the game
 			void completeLevel();
 
 			// Set the game in the victory state
 			void victory();
 
-			// Advance the simulation by a single step
-			// But only if it has been long enough since the last tick
+			// Advance the simulation by as many fixed steps as fit in the real time passed since the last tick
+			// The real time is that of the GlobalStopwatch's last sample
+			// If more than maxCatchUpSteps fit, the rest of the time is dropped and the simulation falls behind
 			void tick();
 
-			// Read and act according to the given inputs
-			void tickInput(double dt);
+			// Account for the real time passed since the last tick without simulating it, returns the number of steps due
+			// For driving the steps from the outside, as tick() would, returns at most maxCatchUpSteps
+			unsigned int dueSteps();
+
+			// Account for the real time passed up to 'now', for driving the steps from a thread of their own
+			unsigned int dueSteps(TimePoint now);
 
-			// Advance a bullet by a single step and check collissions
-			void tickBullet(double dt, std::shared_ptr<Bullet> e, std::vector<std::shared_ptr<Enemy>> enemies, std::vector<std::shared_ptr<Barrier>> barriers);
+			// Get the moment in real time the next step becomes due, by the time passed to the last dueSteps()
+			TimePoint nextStepTime() const;
 
-			// Advance an enemy by a single step and check collissions
-			void tickEnemy(double dt, std::shared_ptr<Enemy> e, std::vector<std::shared_ptr<Barrier>> barriers);
+			// Get the moment in real time the last step became due, by the time passed to the last dueSteps()
+			TimePoint lastStepTime() const;
 
-			// Advance a powerup by a single step and check collissions
-			void tickPowerup(double dt, std::shared_ptr<Powerup> e);
+			// Get the number of seconds of real time between steps, the step length divided by the time scale
+			double getStepPeriod() const;
 
-			// Register a new entity to the simulation
+			// Advance the simulation by exactly a single step, regardless of the real time passed
+			void step();
+
+			// Get the length of a single simulation step in seconds
+			double getStepLength() const;
+
+			// Set how much faster than real time the simulation runs when ticked, 1 by default
+			void setTimeScale(double timeScale);
+
+			// Write the complete state of the simulation to a snapshot, reusing its storage
+			// Settings and the link to the real time clock aren't part of the simulation, so aren't included
+			void saveSnapshot(Snapshot& out) const;
+
+			// Restore the complete state of the simulation from a snapshot taken of a model playing the same levels
+			// Observers are only brought up to date if 'updateObservers' is set, events aren't undone
+			void loadSnapshot(const Snapshot& in, bool updateObservers = true);
+
+			// Take a snapshot of every entity and hand it to every observer
+			void updateEntities();
+
+			// Bring every observer up to date with the complete state of the model, as if it were new
+			void updateObservers();
+
+			// Stop or resume updating the observers, for simulating steps that will be undone or redone
+			// Unmuting brings the observers up to date, events that happened in between are lost
+			void muteObservers(bool muted);
+
+			// Act according to the given inputs of a player
+			void tickInput(double dt, unsigned int player, Ctrl::InputState inputs);
+
+			// Fill 'candidates' with the indices of the entities of the given type that might touch a circle at (x, y)
+			void findCandidates(EntityType type, double x, double y, float size);
+
+			// Advance bullet i of the given type by a single step and check collissions along the way
+			void tickBullet(double dt, EntityType type, unsigned int i);
+
+			// Add the collisions of a circle moving from (x0, y0) to (x1, y1) with entities of the given type to 'collisions'
+			void sweepCandidates(EntityType type, double x0, double y0, double x1, double y1, float size);
+
+			// Let every enemy whose shot is due fire it, and schedule its next one
+			void tickEnemyShots();
+
+			// Advance enemy i of the given type by a single step and check collissions
+			void tickEnemy(EntityType type, unsigned int i);
+
+			// Advance powerup i by a single step and check collissions
+			void tickPowerup(double dt, unsigned int i);
+
+			// Let bullet i of the given type hurt barrier j, based on the health values of both
+			// Can leave the bullet and/or the barrier dead
+			void bulletHurtBarrier(EntityType type, unsigned int i, unsigned int j);
+
+			// Let player bullet i hurt enemy j of the given type, based on the health values of both
+			// Can leave the bullet and/or the enemy dead
+			void bulletHurtEnemy(unsigned int i, EntityType type, unsigned int j);
+
+			// Let enemy i of the given type hurt barrier j
+			// A smallEnemy hurts both itself and the barrier, a bigEnemy destroys the barrier unharmed
+			void enemyHurtBarrier(EntityType type, unsigned int i, unsigned int j);
+
+			// Let enemy i of the given type fire a bullet
+			void enemyShoot(EntityType type, unsigned int i);
+
+			// Destroy enemy i of the given type, pushing back an Event and possibly spawning a Powerup
+			void destroyEnemy(EntityType type, unsigned int i);
+
+			// Destroy barrier i
+			void destroyBarrier(unsigned int i);
+
+			// Register a new event, the observers read it at the end of the step
 			void addEvent(const Event& e);
 
-			// Register a new entity to the simulation
-			void addEntity(std::shared_ptr<Entity> entity);
+			// Advance the simulation by a single step, without letting the observers read its events
+			void simulateStep();
+
+			// Register a new entity to the simulation, returns its handle
+			EntityHandle addEntity(EntityType type, double x, double y, int health = 1, double xvel = 0, double yvel = 0, double xacc = 0, double yacc = 0);
+
+			// Mark entity i of the given type for deletion from the simulation
+			// Deleting an entity that is already marked does nothing and returns false
+			bool deleteEntity(EntityType type, unsigned int i);
+
+			// Remove every entity marked for deletion in a single batch
+			void flushDeletions();
+
+			// Let a player shoot a bullet, if the cooldown allows it
+			void playerShoot(unsigned int player);
+
+			// Move a player left or right
+			void playerMove(unsigned int player, double dx);
 
-			// Delete an entity from the simulation
-			void deleteEntity(std::shared_ptr<Entity> entity);
+			// Hit a player
+			void playerHit(unsigned int player);
 
-			// Hit the player
-			void playerHit();
+			// (re-)spawn a player
+			void playerSpawn(unsigned int player);
 
-			// (re-)spawn the player
-			void playerSpawn();
+			// Get the x position a player spawns at, spreading the players out around the middle
+			double playerSpawnX(unsigned int player) const;
 
 			// "game-over" the player
 			void gameOver();
@@ -0,0 +1,356 @@
+#include "StdAfx.h"
+#include "netplay.h"
+#include "tools.h"
+
+namespace SI {
+	namespace Md {
+
+		// Helper functions
+
+		// The first byte of every packet, telling what kind of packet it is
+		static const std::uint8_t helloPacket = 'H';
+		static const std::uint8_t inputPacket = 'I';
+
+		// The most inputs sent in a single packet, the rest follows in the next ones
+		static const unsigned int maxInputsPerPacket = 64;
+
+		// The number of packets a new checksum is sent along with
+		static const unsigned int checkSends = 8;
+
+		// The number of checksums kept around to be compared
+		static const unsigned int keptChecks = 16;
+
+		static_assert(Ctrl::MAX_INPUTNUM < 4, "Inputs are sent as 4 bits each.");
+
+		// Append 'bytes' bytes of 'value' to 'out', little-endian
+		static void writeFixed(std::vector<std::uint8_t>& out, std::uint64_t value, unsigned int bytes) {
+			for (unsigned int i = 0; i < bytes; ++i)
+				out.push_back(std::uint8_t(value >> (8 * i)));
+		}
+
+		// Read 'bytes' bytes from 'data' starting at 'offset' as a little-endian value, moving 'offset' past them
+		static std::uint64_t readFixed(const std::vector<std::uint8_t>& data, std::size_t& offset, unsigned int bytes) {
+			if (offset + bytes > data.size())
+				throw(std::runtime_error("Packet ends in the middle of a value."));
+			std::uint64_t value = 0;
+			for (unsigned int i = 0; i < bytes; ++i)
+				value |= std::uint64_t(data[offset++]) << (8 * i);
+			return value;
+		}
+
+		// Keep the last 'keptChecks' checksums
+		static void keepCheck(std::vector<std::pair<unsigned long long, std::uint64_t>>& checks, unsigned long long step, std::uint64_t checksum) {
+			if (!checks.empty() && checks.back().first >= step)
+				return;
+			if (checks.size() == keptChecks)
+				checks.erase(checks.begin());
+			checks.push_back({ step, checksum });
+		}
+
+	// netplay_mismatch_exception
+
+		netplay_mismatch_exception::netplay_mismatch_exception(std::string message) : std::runtime_error(message.c_str()) {}
+
+	// RollbackSession
+
+		RollbackSession::RollbackSession(Model& model, std::shared_ptr<Ctrl::InputSource> localInput, std::shared_ptr<Ctrl::Link> link,
+			unsigned int localPlayer, std::uint64_t seed, unsigned int startLevel,
+			unsigned int maxRollback, unsigned int inputDelay, unsigned int checkInterval) :
+			model(model),
+			localInput(localInput),
+			link(link),
+			localPlayer(localPlayer),
+			maxRollback(std::max(1u, maxRollback)),
+			inputDelay(inputDelay),
+			seed(seed),
+			startLevel(startLevel),
+			synchronized(false),
+			heardPeer(false),
+			steps(0),
+			rollbackStep(~0ull),
+			remoteAck(0),
+			snapshots(std::max(1u, maxRollback) + 1),
+			nextCheck(0),
+			checkInterval(std::max(1u, checkInterval)),
+			checkSendsLeft(0),
+			lastComparedCheck(0)
+		{
+			if (localPlayer > 1)
+				throw(std::runtime_error("A netplay session is played by player 1 and 2."));
+			model.setPlayerCount(2);
+			for (unsigned int p = 0; p < 2; ++p) {
+				inputs[p] = std::make_shared<Ctrl::HeldInput>();
+				model.registerInputSource(inputs[p], p);
+			}
+		}
+
+		std::uint8_t RollbackSession::remoteInputAt(unsigned long long step) const {
+			if (step < remoteInputs.size())
+				return remoteInputs[step];
+			// Predict that the peer keeps holding what it held last
+			return remoteInputs.empty() ? 0 : remoteInputs.back();
+		}
+
+		void RollbackSession::start() {
+			model.seed(seed);
+			model.reset(startLevel);
+			steps = 0;
+			localInputs.assign(inputDelay, 0);
+			remoteInputs.clear();
+			usedRemoteInputs.clear();
+			rollbackStep = ~0ull;
+			remoteAck = 0;
+			nextCheck = checkInterval;
+			checks.clear();
+			remoteChecks.clear();
+			checkSendsLeft = 0;
+			lastComparedCheck = 0;
+			synchronized = true;
+		}
+
+		bool RollbackSession::synchronize() {
+			if (synchronized)
+				return true;
+
+			while (link->receive(packet)) {
+				++stats.packetsReceived;
+				try {
+					readPacket();
+				} catch (netplay_mismatch_exception&) {
+					throw;
+				} catch (std::runtime_error&) {
+					++stats.badPackets;
+				}
+			}
+			if (synchronized)
+				return true;
+
+			// Hello: the local player, whether the peer has been heard from, and the game the host wants to play
+			packet.clear();
+			packet.push_back(helloPacket);
+			writeVarint(packet, localPlayer);
+			packet.push_back(heardPeer ? 1 : 0);
+			writeVarint(packet, seed);
+			writeVarint(packet, startLevel);
+			double stepLength = model.getStepLength();
+			std::uint64_t bits;
+			std::memcpy(&bits, &stepLength, sizeof(bits));
+			writeFixed(packet, bits, 8);
+			link->send(packet);
+			++stats.packetsSent;
+			stats.bytesSent += packet.size();
+			return false;
+		}
+
+		bool RollbackSession::isSynchronized() const {
+			return synchronized;
+		}
+
+		void RollbackSession::readPacket() {
+			if (packet.empty())
+				throw(std::runtime_error("Received an empty packet."));
+			std::size_t offset = 1;
+
+			if (packet[0] == helloPacket) {
+				unsigned int player = (unsigned int)readVarint(packet, offset);
+				bool peerHeard = readFixed(packet, offset, 1) != 0;
+				std::uint64_t peerSeed = readVarint(packet, offset);
+				unsigned int peerStartLevel = (unsigned int)readVarint(packet, offset);
+				std::uint64_t bits = readFixed(packet, offset, 8);
+				if (synchronized)
+					return;
+
+				if (player == localPlayer)
+					throw(netplay_mismatch_exception("Both ends of the session play player " + std::to_string(player + 1) + "."));
+				double stepLength;
+				std::memcpy(&stepLength, &bits, sizeof(bits));
+				if (stepLength != model.getStepLength())
+					throw(netplay_mismatch_exception("The peer uses a step length of " + std::to_string(stepLength)
+						+ " seconds, this end uses " + std::to_string(model.getStepLength()) + " seconds."));
+				if (localPlayer != 0) {
+					seed = peerSeed;
+					startLevel = peerStartLevel;
+				}
+				heardPeer = true;
+				if (peerHeard)
+					start();
+				return;
+			}
+
+			if (packet[0] != inputPacket)
+				throw(std::runtime_error("Received a packet of an unknown kind."));
+			// The peer only sends input once it has heard from this end, which means this end has heard from it too
+			if (!synchronized) {
+				if (!heardPeer)
+					return;
+				start();
+			}
+
+			// Inputs: the number of local inputs the peer has, then a range of the peer's inputs, then optionally a checksum
+			unsigned long long ack = readVarint(packet, offset);
+			remoteAck = std::max(remoteAck, std::min<unsigned long long>(ack, localInputs.size()));
+
+			unsigned long long first = readVarint(packet, offset);
+			unsigned long long count = readVarint(packet, offset);
+			if (count > maxInputsPerPacket || offset + (count + 1) / 2 > packet.size())
+				throw(std::runtime_error("Packet holds more inputs than it has room for."));
+			for (unsigned long long k = 0; k < count; ++k) {
+				std::uint8_t input = (packet[offset + k / 2] >> (4 * (k % 2))) & 0xF;
+				unsigned long long step = first + k;
+				// Skip what's already known, and stop at a gap
+				if (step < remoteInputs.size())
+					continue;
+				if (step > remoteInputs.size())
+					break;
+				remoteInputs.push_back(input);
+				if (step < steps && usedRemoteInputs[step] != input)
+					rollbackStep = std::min(rollbackStep, step);
+			}
+			offset += (std::size_t)(count + 1) / 2;
+
+			unsigned long long checkStep = readVarint(packet, offset);
+			if (checkStep) {
+				std::uint64_t checksum = readFixed(packet, offset, 8);
+				keepCheck(remoteChecks, checkStep - 1, checksum);
+			}
+		}
+
+		void RollbackSession::tick() {
+			if (!synchronize())
+				return;
+			poll();
+			for (unsigned int due = model.dueSteps(); due; --due)
+				advance();
+		}
+
+		void RollbackSession::poll() {
+			if (!synchronized)
+				return;
+			while (link->receive(packet)) {
+				++stats.packetsReceived;
+				try {
+					readPacket();
+				} catch (std::runtime_error&) {
+					++stats.badPackets;
+				}
+			}
+			if (rollbackStep < steps)
+				rollback();
+			updateChecks();
+		}
+
+		bool RollbackSession::advance() {
+			if (!synchronized)
+				return false;
+			if (steps >= remoteInputs.size() + maxRollback) {
+				// Wait for the peer to catch up, but make sure it has everything it needs to
+				++stats.stalls;
+				sendInputs();
+				return false;
+			}
+			localInputs.push_back((std::uint8_t)localInput->getInput().to_ulong());
+			simulate();
+			sendInputs();
+			updateChecks();
+			return true;
+		}
+
+		void RollbackSession::rollback() {
+			unsigned long long target = steps;
+			unsigned int depth = (unsigned int)(target - rollbackStep);
+			steps = rollbackStep;
+			rollbackStep = ~0ull;
+
+			// Simulate the steps again without the observers seeing it, then show them the result all at once
+			model.muteObservers(true);
+			model.loadSnapshot(snapshots[steps % snapshots.size()], false);
+			usedRemoteInputs.resize((std::size_t)steps);
+			while (steps < target)
+				simulate();
+			model.muteObservers(false);
+
+			++stats.rollbacks;
+			stats.resimulatedSteps += depth;
+			stats.maxRollbackDepth = std::max(stats.maxRollbackDepth, depth);
+		}
+
+		void RollbackSession::simulate() {
+			model.saveSnapshot(snapshots[steps % snapshots.size()]);
+			std::uint8_t remote = remoteInputAt(steps);
+			usedRemoteInputs.push_back(remote);
+			inputs[localPlayer]->set(Ctrl::InputState(localInputs[steps]));
+			inputs[1 - localPlayer]->set(Ctrl::InputState(remote));
+			model.step();
+			++steps;
+		}
+
+		void RollbackSession::sendInputs() {
+			unsigned long long count = std::min<unsigned long long>(localInputs.size() - remoteAck, maxInputsPerPacket);
+
+			packet.clear();
+			packet.push_back(inputPacket);
+			writeVarint(packet, remoteInputs.size());
+			writeVarint(packet, remoteAck);
+			writeVarint(packet, count);
+			for (unsigned long long k = 0; k < count; k += 2) {
+				std::uint8_t pair = localInputs[remoteAck + k];
+				if (k + 1 < count)
+					pair |= localInputs[remoteAck + k + 1] << 4;
+				packet.push_back(pair);
+			}
+			if (checkSendsLeft && !checks.empty()) {
+				--checkSendsLeft;
+				writeVarint(packet, checks.back().first + 1);
+				writeFixed(packet, checks.back().second, 8);
+			} else {
+				writeVarint(packet, 0);
+			}
+
+			link->send(packet);
+			++stats.packetsSent;
+			stats.bytesSent += packet.size();
+		}
+
+		void RollbackSession::updateChecks() {
+			// A snapshot is final once every input before it is known
+			while (nextCheck < steps && nextCheck <= getConfirmedSteps()) {
+				if (nextCheck + snapshots.size() >= steps) {
+					keepCheck(checks, nextCheck, snapshots[nextCheck % snapshots.size()].checksum());
+					checkSendsLeft = checkSends;
+				}
+				nextCheck += checkInterval;
+			}
+			compareChecks();
+		}
+
+		void RollbackSession::compareChecks() {
+			for (auto& remote : remoteChecks) {
+				if (remote.first <= lastComparedCheck)
+					continue;
+				auto local = std::find_if(checks.begin(), checks.end(),
+					[&remote](const std::pair<unsigned long long, std::uint64_t>& c) { return c.first == remote.first; });
+				if (local == checks.end())
+					continue;
+				lastComparedCheck = remote.first;
+				++stats.checks;
+				if (local->second != remote.second) {
+					++stats.desyncs;
+					std::cout << "Netplay desync detected at step " << remote.first << "!" << std::endl;
+				}
+			}
+		}
+
+		unsigned long long RollbackSession::getSteps() const {
+			return steps;
+		}
+
+		unsigned long long RollbackSession::getConfirmedSteps() const {
+			return std::min<unsigned long long>(remoteInputs.size(), localInputs.size());
+		}
+
+		const NetplayStats& RollbackSession::getStats() const {
+			return stats;
+		}
+
+	}
+}
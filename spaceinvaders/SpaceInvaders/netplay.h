@@ -0,0 +1,182 @@
+#pragma once
+
+#include "StdAfx.h"
+#include "model.h"
+#include "link.h"
+
+namespace SI {
+	namespace Md {
+
+		// An exception thrown when the two ends of a netplay session can't play together, like when both play the same player
+		class netplay_mismatch_exception : public std::runtime_error {
+		public:
+			netplay_mismatch_exception(std::string message);
+		};
+
+		// Tallies of how a netplay session has gone so far
+		struct NetplayStats {
+			// The number of times the model was rolled back, and the number of steps simulated again because of it
+			unsigned long long rollbacks = 0;
+			unsigned long long resimulatedSteps = 0;
+
+			// The most steps a single rollback went back
+			unsigned int maxRollbackDepth = 0;
+
+			// The number of steps that were due but couldn't be taken, because the peer had fallen too far behind
+			unsigned long long stalls = 0;
+
+			// The number of packets and bytes sent and received
+			unsigned long long packetsSent = 0;
+			unsigned long long bytesSent = 0;
+			unsigned long long packetsReceived = 0;
+
+			// The number of received packets that couldn't be read
+			unsigned long long badPackets = 0;
+
+			// The number of checksums of confirmed steps compared with the peer's, and how many of them differed
+			unsigned long long checks = 0;
+			unsigned long long desyncs = 0;
+		};
+
+		// Plays a two player game on a Model with a peer playing the same game on its own Model, over a Link
+		// Only inputs are exchanged: the peer's input is predicted to stay the same until it arrives, and if the
+		// prediction turns out wrong the model is rolled back to a snapshot and simulated again with the real input
+		// The session never runs more than maxRollback steps ahead of the peer's confirmed input, so that no rollback
+		// has to go further back than that
+		// The first player hosts: its seed and start level are the ones both models play with
+		class RollbackSession {
+		private:
+			// The model the game is played on
+			Model& model;
+
+			// The source of the local player's input
+			std::shared_ptr<Ctrl::InputSource> localInput;
+
+			// The link to the peer
+			std::shared_ptr<Ctrl::Link> link;
+
+			// The number of the local player, 0 hosts, the peer plays the other one
+			const unsigned int localPlayer;
+
+			// The most steps the session runs ahead of the peer's confirmed input
+			const unsigned int maxRollback;
+
+			// The number of steps local input is held back before it's played, giving it time to reach the peer
+			const unsigned int inputDelay;
+
+			// The seed and start level of the game
+			std::uint64_t seed;
+			unsigned int startLevel;
+
+			// The input sources through which the session feeds each step's input to the model
+			std::array<std::shared_ptr<Ctrl::HeldInput>, maxPlayers> inputs;
+
+			// Whether or not both ends have heard from each other, and the game has started
+			bool synchronized;
+
+			// Whether or not the peer has been heard from while synchronizing
+			bool heardPeer;
+
+			// The number of steps simulated
+			unsigned long long steps;
+
+			// The local input of every step, including the ones still being held back
+			std::vector<std::uint8_t> localInputs;
+
+			// The peer's input of every step it has been received for, without any gaps
+			std::vector<std::uint8_t> remoteInputs;
+
+			// The peer's input every simulated step was simulated with, predicted or not
+			std::vector<std::uint8_t> usedRemoteInputs;
+
+			// The first step simulated with a wrong prediction, or ~0 if there is none
+			unsigned long long rollbackStep;
+
+			// The number of local inputs the peer has confirmed receiving
+			unsigned long long remoteAck;
+
+			// Snapshots of the model right before each of the last steps, snapshot i % snapshots.size() is of step i
+			std::vector<Snapshot> snapshots;
+
+			// The step the next checksum is taken at, and the number of steps between checksums
+			unsigned long long nextCheck;
+			const unsigned int checkInterval;
+
+			// The last checksums taken of confirmed steps, and the last ones received from the peer, as pairs of step and checksum
+			std::vector<std::pair<unsigned long long, std::uint64_t>> checks;
+			std::vector<std::pair<unsigned long long, std::uint64_t>> remoteChecks;
+
+			// The number of packets the last checksum is still sent along with, so it gets through despite packet loss
+			unsigned int checkSendsLeft;
+
+			// The step of the last checksum that has been compared with the peer's
+			unsigned long long lastComparedCheck;
+
+			// Scratch space for building and receiving packets
+			std::vector<std::uint8_t> packet;
+
+			// The tallies
+			NetplayStats stats;
+
+			// Get the peer's input for a step, predicting it if it hasn't arrived yet
+			std::uint8_t remoteInputAt(unsigned long long step) const;
+
+			// Start the game once both ends have heard from each other
+			void start();
+
+			// Read a packet from the peer, throws a runtime_error if it's malformed and a netplay_mismatch_exception if the
+			// peer can't play with this end
+			void readPacket();
+
+			// Take checksums of the steps that have been confirmed since the last time
+			void updateChecks();
+
+			// Compare the checksums taken by both ends of the same steps
+			void compareChecks();
+
+			// Simulate the steps since the first wrongly predicted one again, with the inputs known now
+			void rollback();
+
+			// Simulate a single step with the inputs known now, snapshotting the model before it
+			void simulate();
+
+		public:
+			// Registers itself as the source of both players' input, and sets the model up for two players
+			// The seed and start level are only used when hosting, the peer's are used otherwise
+			RollbackSession(Model& model, std::shared_ptr<Ctrl::InputSource> localInput, std::shared_ptr<Ctrl::Link> link,
+				unsigned int localPlayer, std::uint64_t seed = 0, unsigned int startLevel = 0,
+				unsigned int maxRollback = 8, unsigned int inputDelay = 2, unsigned int checkInterval = 120);
+
+			// Let the peer know about this end and see if it has answered, resets the model once both ends have
+			// heard from each other, has to be called repeatedly until it returns true
+			// Malformed packets are counted and dropped, a peer that can't play with this end throws a netplay_mismatch_exception
+			bool synchronize();
+
+			// Check whether or not the game has started
+			bool isSynchronized() const;
+
+			// Take as many steps as the real time passed since the last tick calls for, like Model::tick()
+			void tick();
+
+			// Receive the peer's packets, rolling back if any of its input was mispredicted
+			void poll();
+
+			// Take a single step with the local input of the next step, unless it would get too far ahead of the peer
+			// Returns whether or not the step was taken
+			bool advance();
+
+			// Send the peer the local input it hasn't confirmed receiving yet
+			void sendInputs();
+
+			// Get the number of steps simulated
+			unsigned long long getSteps() const;
+
+			// Get the number of steps the input of both players is known for
+			unsigned long long getConfirmedSteps() const;
+
+			// Get the tallies
+			const NetplayStats& getStats() const;
+		};
+
+	}
+}
@@ -4,142 +4,182 @@
 namespace SI {
 	namespace Md {
 
-		// Event
-
-		Event::Event(EventType type, double x, double y, std::string text) :
-			type(type), x(x), y(y), text(text) {}
-
-		double Event::getX(){
-			return x;
-		}
-
-		double Event::getY(){
-			return y;
-		}
-
-		EventType Event::getType(){
-			return type;
-		}
-
-		std::string Event::getText(){
-			return text;
-		}
-		
 		// Payload
 
 			// Getters & Setters
 
-		std::string ModelObserver::getLevelName()const {
+		std::string MirrorObserver::getLevelName()const {
 			return levelName;
 		}
 
-		void ModelObserver::updateLevelName(std::string levelName){
+		void MirrorObserver::updateLevelName(std::string levelName){
 			this->levelName = levelName;
 		}
 
-		unsigned int ModelObserver::getSecondsPassed() const {
+		unsigned int MirrorObserver::getSecondsPassed() const {
 			return secondsPassed;
 		}
 
-		void ModelObserver::updateSecondsPassed(unsigned int secondsPassed) {
+		void MirrorObserver::updateSecondsPassed(unsigned int secondsPassed) {
 			this->secondsPassed = secondsPassed;
 		}
 
-		int ModelObserver::getLives() const {
+		int MirrorObserver::getLives() const {
 			return lives;
 		}
 
-		void ModelObserver::updateLives(int lives) {
+		void MirrorObserver::updateLives(int lives) {
 			this->lives = lives;
 		}
 
-		ModelState ModelObserver::getState() const {
+		ModelState MirrorObserver::getState() const {
 			return state;
 		}
 
-		void ModelObserver::updateState(ModelState state) {
+		void MirrorObserver::updateState(ModelState state) {
 			this->state = state;
 		}
 
-		bool ModelObserver::isPlayerInvinc()const {
-			return playerInvinc;
+		bool MirrorObserver::isPlayerInvinc(unsigned int player)const {
+			return playerInvinc[player];
 		}
 
-		void ModelObserver::updatePlayerInvinc(bool playerInvinc) {
-			this->playerInvinc = playerInvinc;
+		void MirrorObserver::updatePlayerInvinc(unsigned int player, bool playerInvinc) {
+			this->playerInvinc[player] = playerInvinc;
 		}
 
-		bool ModelObserver::isPlayerDead()const {
-			return playerDead;
+		bool MirrorObserver::isPlayerDead(unsigned int player)const {
+			return playerDead[player];
 		}
 
-		void ModelObserver::updatePlayerDead(bool playerDead) {
-			this->playerDead = playerDead;
+		void MirrorObserver::updatePlayerDead(unsigned int player, bool playerDead) {
+			this->playerDead[player] = playerDead;
 		}
 
-		unsigned int ModelObserver::getEntityCount(){
+		unsigned int MirrorObserver::getEntityCount() const {
 			return entityCount;
 		}
 
-		void ModelObserver::updateEntityCount(unsigned int entityCount) {
+		void MirrorObserver::updateEntityCount(unsigned int entityCount) {
 			this->entityCount = entityCount;
 		}
 
-		const std::vector<std::shared_ptr<EntityObserver>>& ModelObserver::getEntityObservers() const{
-			return entityObservers;
+		EntitySpan MirrorObserver::getEntities() const {
+			return EntitySpan(entities);
+		}
+
+		EntitySpan MirrorObserver::getPreviousEntities() const {
+			return EntitySpan(previousEntities);
 		}
 		
 			// Events & Entities
 
-		void ModelObserver::addEvent(Event event) {
-			events.push_back(event);
+		void MirrorObserver::updateEvents(const EventRing& events) {
+			// Only the events written after the observer was registered are popped
+			if (this->events != &events) {
+				this->events = &events;
+				eventCursor = events.end();
+			}
+		}
+
+		const Event* MirrorObserver::popEvent() {
+			if (!events)
+				return nullptr;
+			return events->next(eventCursor);
+		}
+
+		std::uint64_t MirrorObserver::getLostEvents() const {
+			return eventCursor.lost;
+		}
+
+		void MirrorObserver::updateEntities(EntitySpan entities) {
+			previousEntities.swap(this->entities);
+			this->entities.assign(entities.begin(), entities.end());
+
+			// Entries left over from older snapshots are harmless, as a lookup only counts if the handle matches
+			for (unsigned int k = 0; k < previousEntities.size(); ++k) {
+				EntityHandle handle = previousEntities[k].getHandle();
+				if (handle.isNull())
+					continue;
+				if (handle.getSlot() >= previousIndex.size())
+					previousIndex.resize(handle.getSlot() + 1);
+				previousIndex[handle.getSlot()] = k;
+			}
+		}
+
+		void MirrorObserver::interpolateEntities(double fraction, std::vector<EntityObserver>& out) const {
+			out.clear();
+			for (const EntityObserver& e : entities) {
+				// Find the entity in the previous snapshot through its slot
+				std::uint32_t slot = e.getHandle().getSlot();
+				unsigned int k = slot < previousIndex.size() ? previousIndex[slot] : (unsigned int)previousEntities.size();
+				if (k >= previousEntities.size() || previousEntities[k].getHandle() != e.getHandle()) {
+					out.push_back(e);
+					continue;
+				}
+				const EntityObserver& p = previousEntities[k];
+				double x = p.getXpos() + (e.getXpos() - p.getXpos()) * fraction;
+				double y = p.getYpos() + (e.getYpos() - p.getYpos()) * fraction;
+				out.push_back(EntityObserver(e.getHandle(), e.getType(), x, y, e.getHealth()));
+			}
+		}
+
+		MirrorObserver::MirrorObserver() :
+			secondsPassed(0), 
+			lives(0),
+			state(ModelState::running),
+			entityCount(0),
+			events(nullptr)
+		{
+			playerInvinc.fill(false);
+			playerDead.fill(false);
 		}
+		
+		// EntityHandle
 
-		std::vector<Event> ModelObserver::popEvents() {
-			std::vector<Event> out = events;
-			events.clear();
-			return out;
+		EntityHandle::EntityHandle() : value(0xFFFFFFFF) {}
+
+		EntityHandle::EntityHandle(std::uint32_t slot, std::uint32_t generation) :
+			value((generation << slotBits) | (slot & (maxSlots - 1))) {}
+
+		std::uint32_t EntityHandle::getSlot() const {
+			return value & (maxSlots - 1);
 		}
 
-		std::shared_ptr<EntityObserver> ModelObserver::addEntity() {
-			auto newEntity = std::make_shared<EntityObserver>();
-			entityObservers.push_back(newEntity);
-			return newEntity;
+		std::uint32_t EntityHandle::getGeneration() const {
+			return value >> slotBits;
 		}
 
-		void ModelObserver::deleteEntity(std::shared_ptr<EntityObserver> e) {
-			entityObservers.erase(std::remove(entityObservers.begin(), entityObservers.end(), e), entityObservers.end());
+		bool EntityHandle::isNull() const {
+			return value == 0xFFFFFFFF;
 		}
 
-		void ModelObserver::clearEntities(){
-			entityObservers.clear();
+		bool EntityHandle::operator==(const EntityHandle& other) const {
+			return value == other.value;
 		}
 
-		ModelObserver::ModelObserver() :
-			secondsPassed(0), 
-			state(ModelState::running),
-			playerDead(false)
-		{}
-		
-		// PayloadEntity
+		bool EntityHandle::operator!=(const EntityHandle& other) const {
+			return value != other.value;
+		}
 
-		EntityObserver::EntityObserver() {}
+		// EntityObserver
 
-		EntityType EntityObserver::getType() const {
-			return type;
-		}
+		EntityObserver::EntityObserver() :
+			xpos(0), ypos(0), health(0), type(0) {}
+
+		EntityObserver::EntityObserver(EntityHandle handle, EntityType type, double xpos, double ypos, int health) :
+			handle(handle), xpos((float)xpos), ypos((float)ypos), health((std::int16_t)health), type((std::uint8_t)type) {}
 
-		void EntityObserver::updateType(EntityType type){
-			this->type = type;
+		EntityHandle EntityObserver::getHandle() const {
+			return handle;
 		}
 
-		double EntityObserver::getXpos()const {
-			return xpos;
+		EntityType EntityObserver::getType() const {
+			return (EntityType)type;
 		}
 
-		void EntityObserver::updatePosition(double xpos, double ypos) {
-			this->xpos = xpos;
-			this->ypos = ypos;
+		double EntityObserver::getXpos() const {
+			return xpos;
 		}
 
 		double EntityObserver::getYpos() const {
@@ -150,8 +190,28 @@ namespace SI {
 			return health;
 		}
 
-		void EntityObserver::updateHealth(int health) {
-			this->health = health;
+		// EntitySpan
+
+		EntitySpan::EntitySpan() : first(nullptr), count(0) {}
+
+		EntitySpan::EntitySpan(const EntityObserver* first, unsigned int count) : first(first), count(count) {}
+
+		EntitySpan::EntitySpan(const std::vector<EntityObserver>& entities) : first(entities.data()), count(entities.size()) {}
+
+		const EntityObserver* EntitySpan::begin() const {
+			return first;
+		}
+
+		const EntityObserver* EntitySpan::end() const {
+			return first + count;
+		}
+
+		unsigned int EntitySpan::size() const {
+			return count;
+		}
+
+		const EntityObserver& EntitySpan::operator[](unsigned int i) const {
+			return first[i];
 		}
 
 	}
@@ -1,5 +1,6 @@
 #pragma once
 #include "StdAfx.h"
+#include "events.h"
 
 namespace SI {
 	namespace Md {
@@ -11,86 +12,137 @@ namespace SI {
 			running, paused, gameOver, levelSwitch, victory
 		};
 
-		// An enum representing a type of event
-		enum EventType {
-			friendlyShotFired, bulletHit, friendlyHit, pickup,
-			enemyHit, enemyShotFired, smallEnemyDestroyed, bigEnemyDestroyed,
-			barrierHit, barrierDestroyed, 
-			paused, unPaused, gameOver
+		// The maximum number of players a game can be played by
+		const unsigned int maxPlayers = 2;
+
+		// An enum representing a crude abstraction of types of entities
+		enum EntityType {
+			player, smallEnemy, bigEnemy, playerBullet, enemyBullet, barrier, powerup
 		};
 
-		// A struct representing type of event, and possibly its location and related text
-		struct Event {
-		protected:
-			// The optional x and y values of the event
-			double x, y;
+		// The number of different EntityTypes, used to size per-type collections
+		const unsigned int entityTypeCount = powerup + 1;
 
-			// The optional text of the event
-			std::string text;
+		// A 32-bit generational handle identifying an entity
+		// The low bits index a slot, the high bits hold the generation of that slot when the handle was made,
+		// so a handle to a deleted entity can be told apart from a handle to a later entity reusing its slot
+		class EntityHandle {
+		private:
+			std::uint32_t value;
 
-			// The type of the event
-			EventType type;
 		public:
-			Event(EventType type, double x = 0, double y = 0, std::string text = "");
+			// The number of bits used for the slot index
+			static const unsigned int slotBits = 20;
+			// The largest number of slots that can be addressed
+			static const std::uint32_t maxSlots = 1u << slotBits;
 
-			// Get the x value
-			double getX();
+			// Create an invalid handle
+			EntityHandle();
+			EntityHandle(std::uint32_t slot, std::uint32_t generation);
 
-			// Get the y value
-			double getY();
+			// Get the index of the slot
+			std::uint32_t getSlot() const;
 
-			// Get the text value
-			std::string getText();
+			// Get the generation of the slot
+			std::uint32_t getGeneration() const;
 
-			// Get the event's type
-			EventType getType();
-		};
-				
-		// An enum representing a crude abstraction of types of entities
-		enum EntityType {
-			player, smallEnemy, bigEnemy, playerBullet, enemyBullet, barrier, powerup
+			// Check whether or not the handle refers to anything at all
+			bool isNull() const;
+
+			bool operator==(const EntityHandle& other) const;
+			bool operator!=(const EntityHandle& other) const;
 		};
 
-		// A struct representing all the data a view can know about an entity
+		// All the data a view can know about an entity, as one element of the snapshot the model takes of its entities
+		// every step, kept small so that a snapshot is a compact run of memory read front to back
 		class EntityObserver {
 		private:
-			// The type of Entity that's being observed
-			EntityType type;
+			// The handle of the observed entity
+			EntityHandle handle;
+
+			// The observed x and y positions of the entity in the world
+			float xpos, ypos;
 
-			// The last observed x and y positions of the observed Entity
-			double xpos, ypos;
+			// The observed health value of the entity
+			std::int16_t health;
 
-			// The last observed health value of the observed Entity
-			int health;
+			// The type of the observed entity
+			std::uint8_t type;
 
 		public:
 			EntityObserver();
+			EntityObserver(EntityHandle handle, EntityType type, double xpos, double ypos, int health);
+
+			// Get the handle of the observed entity
+			EntityHandle getHandle() const;
 
 			// Get the type of the observed entity
 			EntityType getType() const;
 
-			// As an entity, update your observed type
-			void updateType(EntityType type);
-
-			// Get the xpos of the of the observed entity
+			// Get the position of the observed entity in the world
 			double getXpos() const;
-			// Get the ypos of the of the observed entity
 			double getYpos() const;
 
-			// As an entity, update your observed position
-			void updatePosition(double xpos, double ypos);
-
-			// Get the health value of the of the observed entity
+			// Get the health value of the observed entity
 			int getHealth() const;
+		};
+
+		// A read-only view of a contiguous run of EntityObservers, only valid for as long as the storage it views
+		class EntitySpan {
+		private:
+			const EntityObserver* first;
+			unsigned int count;
 
-			// As an entity, update your observed health value
-			void updateHealth(int health);
+		public:
+			EntitySpan();
+			EntitySpan(const EntityObserver* first, unsigned int count);
+			EntitySpan(const std::vector<EntityObserver>& entities);
 
+			const EntityObserver* begin() const;
+			const EntityObserver* end() const;
+
+			// Get the number of EntityObservers viewed
+			unsigned int size() const;
+
+			const EntityObserver& operator[](unsigned int i) const;
 		};
 
 
-		// A struct representing all the data a view can know about a model
+		// An interface for objects which the model keeps updated on its state, its entities and its events
 		class ModelObserver {
+		public:
+			virtual ~ModelObserver() {}
+
+			// Update the observed level name
+			virtual void updateLevelName(std::string levelName) = 0;
+
+			// Update the observed seconds passed
+			virtual void updateSecondsPassed(unsigned int secondsPassed) = 0;
+
+			// Update the observed player lives
+			virtual void updateLives(int lives) = 0;
+
+			// Update the observed model state
+			virtual void updateState(ModelState state) = 0;
+
+			// Update the observed states of a player
+			virtual void updatePlayerInvinc(unsigned int player, bool playerInvinc) = 0;
+			virtual void updatePlayerDead(unsigned int player, bool playerDead) = 0;
+
+			// Update the observed entity count, for debug purposes
+			virtual void updateEntityCount(unsigned int entityCount) = 0;
+
+			// Read the events written since the last update through the observer's own cursor, the model calls this every step
+			// The model's ring stays the same for as long as the observer is registered
+			virtual void updateEvents(const EventRing& events) = 0;
+
+			// Read the snapshot of every entity, the model calls this once at the end of every step
+			// The span is only valid during the call, an observer that keeps the entities has to copy them
+			virtual void updateEntities(EntitySpan entities) = 0;
+		};
+
+		// A ModelObserver which keeps a copy of all the data a view can know about a model
+		class MirrorObserver : public ModelObserver {
 
 		// ____VALUES_____________________
 					
@@ -106,65 +158,75 @@ namespace SI {
 			// The observed state of the model
 			ModelState state;
 
-			// The observed states of the player
-			bool playerInvinc;
-			bool playerDead;
+			// The observed states of every player
+			std::array<bool, maxPlayers> playerInvinc;
+			std::array<bool, maxPlayers> playerDead;
 
 			// The observed number of entities, for debug purposes
 			unsigned int entityCount;
 
-			// A number of observed Events
-			std::vector<Event> events;
+			// The model's ring of events, and the position up to which they have been popped
+			const EventRing* events;
+			EventRing::Cursor eventCursor;
 
-			// A number of PayloadEntities, each uniquely updated by their own specific Entity
-			std::vector<std::shared_ptr<EntityObserver>> entityObservers;
+			// A copy of the latest snapshot of every entity, and of the one before it
+			std::vector<EntityObserver> entities;
+			std::vector<EntityObserver> previousEntities;
+
+			// The index in the previous snapshot of the entity last seen in each slot, checked against its handle before use
+			std::vector<unsigned int> previousIndex;
 
 		public:
-			ModelObserver();
+			MirrorObserver();
 
 			// Get and update the observed level name
 			std::string getLevelName() const;
-			void updateLevelName(std::string levelName);
+			virtual void updateLevelName(std::string levelName);
 
 			// Get and update the observed seconds passed
 			unsigned int getSecondsPassed() const;
-			void updateSecondsPassed(unsigned int secondsPassed);
+			virtual void updateSecondsPassed(unsigned int secondsPassed);
 
 			// Get and update the observed player lives
 			int getLives() const;
-			void updateLives (int lives);
+			virtual void updateLives(int lives);
 
 			// Get and update the observed model state
 			ModelState getState() const;
-			void updateState (ModelState state);
+			virtual void updateState(ModelState state);
 
-			// Get and update the observed player states
-			bool isPlayerInvinc() const;
-			void updatePlayerInvinc(bool playerInvinc);
-			bool isPlayerDead() const;
-			void updatePlayerDead(bool playerDead);
+			// Get and update the observed states of a player
+			bool isPlayerInvinc(unsigned int player = 0) const;
+			virtual void updatePlayerInvinc(unsigned int player, bool playerInvinc);
+			bool isPlayerDead(unsigned int player = 0) const;
+			virtual void updatePlayerDead(unsigned int player, bool playerDead);
 
 			// Get and update the observed entity count, for debug purposes
-			unsigned int getEntityCount();
-			void updateEntityCount(unsigned int entityCount);
+			unsigned int getEntityCount() const;
+			virtual void updateEntityCount(unsigned int entityCount);
 
-			// Get a reference to the vector of EntityObservers, so that they may be drawn
-			const std::vector<std::shared_ptr<EntityObserver>>& getEntityObservers() const;
+			// Get the latest snapshot of every entity, so that they may be drawn
+			EntitySpan getEntities() const;
 
-			// Register an event
-			void addEvent(Event event);
+			// Get the snapshot of every entity before the latest one
+			EntitySpan getPreviousEntities() const;
 
-			// Pop all stored events
-			std::vector<Event> popEvents();
-			
-			// Start observing a new entity and return a pointer to its observer
-			std::shared_ptr<EntityObserver> addEntity();
+			// Fill 'out' with the latest snapshot of every entity, each moved back towards its position in the snapshot
+			// before it: 'fraction' 0 gives the previous positions and 1 the latest ones
+			// Entities that weren't in the previous snapshot are at their latest positions
+			void interpolateEntities(double fraction, std::vector<EntityObserver>& out) const;
 
-			// Remove an entity
-			void deleteEntity(std::shared_ptr<EntityObserver> e);
+			// Keep track of the model's ring of events, the events are only read when popped
+			virtual void updateEvents(const EventRing& events);
 
-			// Clear all entities
-			void clearEntities();
+			// Pop the next event, or nullptr if there is none, the event is read straight from the model's ring
+			const Event* popEvent();
+
+			// Get the number of events that were overwritten before they were popped
+			std::uint64_t getLostEvents() const;
+			
+			// Copy the latest snapshot of every entity, keeping the one before it and reusing the storage of the one before that
+			virtual void updateEntities(EntitySpan entities);
 		};
 
 	}
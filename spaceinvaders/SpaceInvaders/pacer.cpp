@@ -0,0 +1,86 @@
+#include "StdAfx.h"
+#include "pacer.h"
+
+namespace SI
+{
+	namespace Time {
+
+	// PacingStats
+
+		double PacingStats::meanLateness() const {
+			return waits ? lateness / waits : 0;
+		}
+
+		double PacingStats::jitter() const {
+			if (!waits)
+				return 0;
+			double mean = meanLateness();
+			return std::sqrt(std::max(latenessSquared / waits - mean * mean, 0.0));
+		}
+
+		std::ostream& operator<<(std::ostream& out, const PacingStats& stats) {
+			out << stats.waits << " waits, woke up " << stats.meanLateness() * 1e6 << " us late on average, jitter "
+				<< stats.jitter() * 1e6 << " us, at most " << stats.maxLateness * 1e6 << " us late, "
+				<< stats.slept << " s slept, " << stats.spun << " s spun";
+			return out;
+		}
+
+	// Pacer
+
+		Pacer::Pacer(double minMargin, double maxMargin, double marginStep) :
+			stopwatch(GlobalStopwatch::getInstance()),
+			margin(minMargin),
+			minMargin(minMargin),
+			maxMargin(maxMargin),
+			marginStep(marginStep)
+		{}
+
+		void Pacer::waitUntil(TimePoint deadline) {
+			TimePoint now = stopwatch->read();
+			if (now >= deadline)
+				return;
+
+			double remaining = nanoToSeconds(deadline - now);
+			if (remaining > margin) {
+				// Sleep until the margin before the deadline, and see how far the sleep overshot
+				TimePoint wake = deadline - std::chrono::duration_cast<TimePoint::duration>(std::chrono::duration<double>(margin));
+				std::this_thread::sleep_for(wake - now);
+				TimePoint slept = stopwatch->read();
+				stats.slept += nanoToSeconds(slept - now);
+
+				// Follow roughly the 95th percentile of the overshoots: widen the margin by 19 steps when a sleep overshoots it,
+				// narrow it by one otherwise, so that it settles where one in 20 sleeps overshoots it
+				// A single sleep that overshoots by far, as happens on a busy machine, only widens it a little
+				double overshoot = nanoToSeconds(slept - wake);
+				if (overshoot > margin)
+					margin = std::min(margin + 19 * marginStep, maxMargin);
+				else
+					margin = std::max(margin - marginStep, minMargin);
+				now = slept;
+			}
+
+			// Spin for the rest
+			TimePoint spinStart = now;
+			while (now < deadline) {
+				std::this_thread::yield();
+				now = stopwatch->read();
+			}
+			stats.spun += nanoToSeconds(now - spinStart);
+
+			double late = nanoToSeconds(now - deadline);
+			++stats.waits;
+			stats.lateness += late;
+			stats.latenessSquared += late * late;
+			stats.maxLateness = std::max(stats.maxLateness, late);
+		}
+
+		const PacingStats& Pacer::getStats() const {
+			return stats;
+		}
+
+		double Pacer::getMargin() const {
+			return margin;
+		}
+
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "StdAfx.h"
+#include "stopwatch.h"
+
+namespace SI
+{
+	namespace Time {
+
+		// Statistics of how precisely a Pacer woke its thread up
+		struct PacingStats {
+			// The number of waits
+			unsigned long long waits = 0;
+
+			// The sum of, the sum of the squares of and the largest number of seconds woken up after the deadline
+			double lateness = 0, latenessSquared = 0, maxLateness = 0;
+
+			// The number of seconds spent sleeping, and spinning right before the deadline
+			double slept = 0, spun = 0;
+
+			// Get the average number of seconds woken up after the deadline
+			double meanLateness() const;
+
+			// Get the standard deviation of the number of seconds woken up after the deadline
+			double jitter() const;
+		};
+
+		// Makes a thread wait until a deadline in real time, without keeping a core busy
+		// Waits by sleeping until shortly before the deadline, then spinning for the last stretch, since a sleep may
+		// overshoot by as much as the scheduler's tick
+		// The stretch spun for follows how far the sleeps overshoot on this machine
+		class Pacer {
+		private:
+			// The stopwatch the real time is read from, without sampling it
+			std::shared_ptr<GlobalStopwatch> stopwatch;
+
+			// The number of seconds before the deadline to stop sleeping and start spinning
+			double margin;
+
+			// The smallest and largest margin, and the step it is adjusted by after every sleep
+			double minMargin, maxMargin, marginStep;
+
+			// The statistics of the waits so far
+			PacingStats stats;
+
+		public:
+			Pacer(double minMargin = 0.0002, double maxMargin = 0.005, double marginStep = 0.00002);
+
+			// Wait until the given moment by the global stopwatch, returns right away if it has already passed
+			void waitUntil(TimePoint deadline);
+
+			// Get the statistics of the waits so far
+			const PacingStats& getStats() const;
+
+			// Get the current margin in seconds
+			double getMargin() const;
+		};
+
+		// Write the statistics on a single line
+		std::ostream& operator<<(std::ostream& out, const PacingStats& stats);
+
+	}
+}
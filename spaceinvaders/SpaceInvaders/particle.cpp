@@ -4,50 +4,151 @@
 namespace SI {
 	namespace Vw {
 
+		// Add 'rates' times 'dt' to every one of 'count' values
+		// The arrays are declared not to overlap, so that the compiler vectorizes the loop without checking for it first
+		static void integrate(float* __restrict values, const float* __restrict rates, float dt, unsigned int count) {
+			for (unsigned int i = 0; i < count; ++i)
+				values[i] += rates[i] * dt;
+		}
 
-		// Particle 
+		// ParticleSystem
 
-		Particle::Particle(double x, double y, double xvel, double yvel, double size, double sized, double lifeTime, sf::Color color) :
-			x(x), y(y), xvel(xvel), yvel(yvel), size(size), sized(sized), aliveTimer(lifeTime), color(color)
-		{}
+		ParticleSystem::ParticleSystem(unsigned int capacity) :
+			count(0), capacity(0), highWaterMark(0)
+		{
+			grow(capacity);
+		}
 
-		bool Particle::alive(){
-			return (aliveTimer() && size > 0);
+		void ParticleSystem::grow(unsigned int capacity) {
+			this->capacity = capacity;
+			x.resize(capacity);
+			y.resize(capacity);
+			xvel.resize(capacity);
+			yvel.resize(capacity);
+			size.resize(capacity);
+			sized.resize(capacity);
+			life.resize(capacity);
+			color.resize(capacity);
 		}
 
-		double Particle::getX() const {
-			return x;
+		void ParticleSystem::add(double x, double y, double xvel, double yvel, double size, double sized, double lifeTime, sf::Color color) {
+			if (count == capacity) {
+				unsigned int grown = std::max(1024u, capacity * 2);
+				std::cout << "Warning: particle system full at " << capacity << " particles, growing to " << grown << "." << std::endl;
+				grow(grown);
+			}
+			unsigned int i = count++;
+			this->x[i] = (float)x;
+			this->y[i] = (float)y;
+			this->xvel[i] = (float)xvel;
+			this->yvel[i] = (float)yvel;
+			this->size[i] = (float)size;
+			this->sized[i] = (float)sized;
+			this->life[i] = (float)lifeTime;
+			this->color[i] = color;
+			highWaterMark = std::max(highWaterMark, count);
 		}
 
-		double Particle::getY() const {
-			return y;
+		void ParticleSystem::tick(double dt) {
+			float step = (float)dt;
+			integrate(x.data(), xvel.data(), step, count);
+			integrate(y.data(), yvel.data(), step, count);
+			integrate(size.data(), sized.data(), step, count);
+			for (unsigned int i = 0; i < count; ++i)
+				life[i] -= step;
+
+			// Move the last particle into the place of every dead one, checking the moved particle in turn
+			unsigned int i = 0;
+			while (i < count) {
+				if (life[i] > 0 && size[i] > 0) {
+					++i;
+					continue;
+				}
+				unsigned int last = --count;
+				x[i] = x[last];
+				y[i] = y[last];
+				xvel[i] = xvel[last];
+				yvel[i] = yvel[last];
+				size[i] = size[last];
+				sized[i] = sized[last];
+				life[i] = life[last];
+				color[i] = color[last];
+			}
 		}
 
-		double Particle::getSize() const {
-			return size;
+		void ParticleSystem::draw(SpriteBatch& batch, float grid) const {
+			for (unsigned int i = 0; i < count; ++i) {
+				// Rounded to the nearest line of the grid, the same as align() does for positive coordinates
+				float side = grid * std::floor(size[i] / grid + 0.5f);
+				float left = grid * std::floor((x[i] - side / 2) / grid + 0.5f);
+				float top = grid * std::floor((y[i] - side / 2) / grid + 0.5f);
+				batch.addRectangle(left, top, side, side, color[i]);
+			}
 		}
 
-		sf::Color Particle::getColor() const {
-			return color;
+		void ParticleSystem::clear() {
+			count = 0;
 		}
 
-		void Particle::tick(double dt){
-			if (!alive())
-				return;
-			x += xvel * dt;
-			y += yvel * dt;
-			size += sized * dt;
+		unsigned int ParticleSystem::getCount() const {
+			return count;
 		}
 
-		// TextParticle : Particle
+		unsigned int ParticleSystem::getCapacity() const {
+			return capacity;
+		}
 
-		TextParticle::TextParticle(std::string text, double x, double y, double xvel, double yvel, double lifeTime, sf::Color color) : 
-			Particle(x, y, xvel, yvel, 10.0, 0.0, lifeTime, color), text(text)
+		unsigned int ParticleSystem::getHighWaterMark() const {
+			return highWaterMark;
+		}
+
+		float ParticleSystem::getX(unsigned int i) const {
+			return x[i];
+		}
+
+		float ParticleSystem::getY(unsigned int i) const {
+			return y[i];
+		}
+
+		float ParticleSystem::getSize(unsigned int i) const {
+			return size[i];
+		}
+
+		sf::Color ParticleSystem::getColor(unsigned int i) const {
+			return color[i];
+		}
+
+		// TextParticle
+
+		TextParticle::TextParticle(std::string text, double x, double y, double xvel, double yvel, double lifeTime, sf::Color color) :
+			text(text), x(x), y(y), xvel(xvel), yvel(yvel), life(lifeTime), color(color)
 		{}
 
-		std::string TextParticle::getText() const {
+		bool TextParticle::alive() const {
+			return life > 0;
+		}
+
+		double TextParticle::getX() const {
+			return x;
+		}
+
+		double TextParticle::getY() const {
+			return y;
+		}
+
+		sf::Color TextParticle::getColor() const {
+			return color;
+		}
+
+		const std::string& TextParticle::getText() const {
 			return text;
 		}
-		
+
+		void TextParticle::tick(double dt) {
+			x += xvel * dt;
+			y += yvel * dt;
+			life -= dt;
+		}
+
 	}
 }
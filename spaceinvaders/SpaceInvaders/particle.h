@@ -1,54 +1,103 @@
 #pragma once
 #include "StdAfx.h"
-#include "time.h"
-#include "tools.h"
+#include <SFML/Graphics.hpp>
+#include "batch.h"
 
 namespace SI {
 	namespace Vw {
 
-		class Particle {
-		protected:
-			// The coordinates of the particle
-			double x, y;
-			// The particle's velocity
-			double xvel, yvel;
-			// The particle's size and size gained per second
-			double size, sized;
-			// The particle's color
-			sf::Color color;
+		// Every particle of the explosions, as a structure of arrays: particle i is described by the i'th element of each array
+		// Ticking them is a few branchless passes over contiguous floats, which the compiler vectorizes
+		// A particle dies once its lifetime runs out or it has shrunk away, and is removed by moving the last particle into its place
+		class ParticleSystem {
+		private:
+			// The number of live particles, the first 'count' elements of each array
+			unsigned int count;
+
+			// The number of particles the arrays have room for, and the largest number that has been alive at once
+			unsigned int capacity, highWaterMark;
+
+			// The particles' coordinates
+			std::vector<float> x, y;
+
+			// The particles' velocities
+			std::vector<float> xvel, yvel;
+
+			// The particles' sizes and sizes gained per second
+			std::vector<float> size, sized;
+
+			// The number of seconds each particle has left to live
+			std::vector<float> life;
+
+			// The particles' colors
+			std::vector<sf::Color> color;
+
+			// Make room for 'capacity' particles
+			void grow(unsigned int capacity);
 
-			// Timer determining the particle's lifetime
-			Time::WithinPeriodTimer aliveTimer;
-			
 		public:
-			Particle(double x = 0.0f, double y = 0.0f, double xvel = 0.0f, double yvel = 0.0f, double size = 10.0f, double sized = 0.0f, double lifeTime = 1.0f, sf::Color color = sf::Color(169, 202, 30));
-			
-			// Get whether or not the particle is still alive
-			bool alive();
+			ParticleSystem(unsigned int capacity);
 
-			// Get the particle's x position
-			double getX() const;
-			// Get the particle's y position
-			double getY() const;
-			// Get the particle's size
-			double getSize() const;
-			// Get the particle's color
-			sf::Color getColor() const;
+			// Add a particle, if the arrays are full they grow, logging a warning since they should have been made large enough
+			void add(double x, double y, double xvel, double yvel, double size, double sized, double lifeTime, sf::Color color);
+
+			// Move, grow and age every particle by 'dt' seconds, then remove the dead ones in a single pass
+			void tick(double dt);
+
+			// Add a square for every particle to 'batch', its position and size aligned to a grid of 'grid' pixels
+			void draw(SpriteBatch& batch, float grid) const;
+
+			// Remove every particle
+			void clear();
+
+			// Get the number of live particles
+			unsigned int getCount() const;
 
-			virtual void tick(double dt);
+			// Get the number of particles there's room for without growing, and the largest number alive at once
+			unsigned int getCapacity() const;
+			unsigned int getHighWaterMark() const;
+
+			// Get the position, size and color of particle i
+			float getX(unsigned int i) const;
+			float getY(unsigned int i) const;
+			float getSize(unsigned int i) const;
+			sf::Color getColor(unsigned int i) const;
 		};
 
-		// A particle representing a piece of text
-		class TextParticle : public Particle {
-		protected:
+		// A piece of text floating away, such as the name of a powerup that was picked up
+		class TextParticle {
+		private:
 			std::string text;
+
+			// The coordinates and velocity of the text
+			double x, y;
+			double xvel, yvel;
+
+			// The number of seconds the text has left to live
+			double life;
+
+			// The text's color
+			sf::Color color;
+
 		public:
 			TextParticle(std::string text, double x = 0.0f, double y = 0.0f, double xvel = 0.0f, double yvel = 0.0f, double lifeTime = 1.0f, sf::Color color = sf::Color(169, 202, 30));
 
+			// Get whether or not the text is still alive
+			bool alive() const;
+
+			// Get the text's position
+			double getX() const;
+			double getY() const;
+
+			// Get the text's color
+			sf::Color getColor() const;
+
 			// Get the text particle's text
-			std::string getText() const;
-		};
+			const std::string& getText() const;
 
+			// Move and age the text by 'dt' seconds
+			void tick(double dt);
+		};
 
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,63 @@
+#include "StdAfx.h"
+#include "playback.h"
+
+namespace SI {
+	namespace Md {
+
+		ReplayPlayer::ReplayPlayer(Model& model, std::shared_ptr<const Ctrl::Replay> replay, unsigned int keyframeInterval) :
+			model(model),
+			replay(replay),
+			input(std::make_shared<Ctrl::ReplayInput>(replay)),
+			steps(0),
+			keyframeInterval(std::max(1u, keyframeInterval))
+		{
+			if (model.getStepLength() != replay->getStepLength())
+				throw(std::runtime_error("The replay was recorded with a step length of " + std::to_string(replay->getStepLength())
+					+ " seconds, the model uses " + std::to_string(model.getStepLength()) + " seconds."));
+			model.registerInputSource(input);
+			restart();
+		}
+
+		void ReplayPlayer::restart() {
+			model.seed(replay->getSeed());
+			model.reset(replay->getStartLevel());
+			input->seek(0);
+			steps = 0;
+		}
+
+		void ReplayPlayer::step() {
+			if (steps % keyframeInterval == 0 && (keyframes.empty() || keyframes.back().step < steps)) {
+				keyframes.push_back({ steps, Snapshot() });
+				model.saveSnapshot(keyframes.back().snapshot);
+			}
+			model.step();
+			++steps;
+		}
+
+		void ReplayPlayer::seek(unsigned long long target) {
+			// Find the last keyframe at or before the target
+			auto it = std::upper_bound(keyframes.begin(), keyframes.end(), target,
+				[](unsigned long long s, const Keyframe& k) { return s < k.step; });
+
+			if (it != keyframes.begin() && (target < steps || (it - 1)->step > steps)) {
+				--it;
+				model.loadSnapshot(it->snapshot);
+				input->seek(it->step);
+				steps = it->step;
+			} else if (target < steps) {
+				restart();
+			}
+			while (steps < target)
+				step();
+		}
+
+		unsigned long long ReplayPlayer::getStep() const {
+			return steps;
+		}
+
+		bool ReplayPlayer::isFinished() const {
+			return steps >= replay->getSteps();
+		}
+
+	}
+}
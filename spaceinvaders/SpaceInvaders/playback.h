@@ -0,0 +1,61 @@
+#pragma once
+
+#include "StdAfx.h"
+#include "model.h"
+#include "replay.h"
+
+namespace SI {
+	namespace Md {
+
+		// Plays a Replay back on a Model, as fast as it's stepped
+		// Snapshots of the model are kept at regular intervals while playing, so that seeking only re-simulates
+		// the steps since the closest snapshot
+		class ReplayPlayer {
+		private:
+			// A snapshot of the model taken right before playing back a step
+			struct Keyframe {
+				unsigned long long step;
+				Snapshot snapshot;
+			};
+
+			// The model the replay is played back on
+			Model& model;
+
+			// The replay
+			std::shared_ptr<const Ctrl::Replay> replay;
+
+			// The input source feeding the replay to the model
+			std::shared_ptr<Ctrl::ReplayInput> input;
+
+			// The number of steps played back
+			unsigned long long steps;
+
+			// The number of steps between keyframes
+			unsigned int keyframeInterval;
+
+			// The keyframes taken so far, in order of their steps
+			std::vector<Keyframe> keyframes;
+
+		public:
+			// Registers itself as the model's input source, and restarts the game the replay was recorded from
+			// Throws if the model's step length doesn't match the replay's
+			ReplayPlayer(Model& model, std::shared_ptr<const Ctrl::Replay> replay, unsigned int keyframeInterval = 1200);
+
+			// Restart the game the replay was recorded from
+			void restart();
+
+			// Play back a single step
+			void step();
+
+			// Play back up to the given step, starting from the closest keyframe before it
+			void seek(unsigned long long target);
+
+			// Get the number of steps played back
+			unsigned long long getStep() const;
+
+			// Check whether or not every recorded step has been played back
+			bool isFinished() const;
+		};
+
+	}
+}
@@ -6,21 +6,34 @@ namespace SI {
 
 	// Class: RNG
 
-		// private:
-			// Static data member:
-		std::shared_ptr<RNG> RNG::self;
+		RNG::RNG(std::uint64_t seed) {
+			this->seed(seed);
+		}
 
-		RNG::RNG() : 
-			generator(randomDevice())
-		{}
+		std::uint64_t RNG::randomSeed() {
+			std::random_device randomDevice;
+			return (std::uint64_t(randomDevice()) << 32) ^ randomDevice();
+		}
 
+		void RNG::seed(std::uint64_t seed) {
+			// Expand the seed with splitmix64, so that similar seeds still give unrelated states
+			for (std::uint64_t& s : state) {
+				std::uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				s = z ^ (z >> 31);
+			}
+		}
+
+		void RNG::reals(double* out, std::size_t count) {
+			for (std::size_t i = 0; i < count; ++i)
+				out[i] = real();
+		}
 
-		// public:
-		
-		std::shared_ptr<RNG> RNG::getInstance() {
-			if (self == NULL)
-				self = std::shared_ptr<RNG>(new RNG);
-			return self;
+		void RNG::realsFromRange(double* out, std::size_t count, double min, double max) {
+			reals(out, count);
+			for (std::size_t i = 0; i < count; ++i)
+				out[i] = min + out[i] * (max - min);
 		}
 	}
-}
\ No newline at end of file
+}
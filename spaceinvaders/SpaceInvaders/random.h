@@ -1,53 +1,120 @@
 #pragma once
 
 #include "StdAfx.h"
+#include "snapshot.h"
 
 namespace SI {
 	namespace RNG {
 
-	// A Singleton class that offers various Random Number Generating tools
+	// A small, fast and explicitly seedable random number generator offering various tools, based on xoshiro256**
+	// Every simulation owns its own instance, so that a game can be reproduced from its seed
+	// Also satisfies UniformRandomBitGenerator, so it can be used with the standard distributions
 		class RNG {
 		private:
-			// Self pointer
-			static std::shared_ptr<RNG> self;
+			// The generator's state
+			std::uint64_t state[4];
 
-			// RNG entities
-			std::random_device randomDevice;
-			std::mt19937 generator;
-
-			RNG();
+			// Rotate x left by k bits
+			static std::uint64_t rotl(std::uint64_t x, int k) {
+				return (x << k) | (x >> (64 - k));
+			}
 
 		public:
+			typedef std::uint64_t result_type;
+
+			// Create an RNG with the given seed
+			RNG(std::uint64_t seed = randomSeed());
+
+			// Get a seed from the system's source of randomness
+			static std::uint64_t randomSeed();
+
+			// Reset the generator's state based off the given seed
+			void seed(std::uint64_t seed);
+
+			// Write the generator's state to a snapshot
+			void save(Snapshot& out) const {
+				out.write(state);
+			}
+
+			// Read the generator's state back from a snapshot
+			void load(Snapshot::Reader& in) {
+				in.read(state);
+			}
 
-			// Get a pointer to the only existing RNG instance
-			static std::shared_ptr<RNG> getInstance();
+			// Get 64 random bits
+			std::uint64_t next() {
+				const std::uint64_t result = rotl(state[1] * 5, 7) * 9;
+				const std::uint64_t t = state[1] << 17;
+				state[2] ^= state[0];
+				state[3] ^= state[1];
+				state[1] ^= state[2];
+				state[0] ^= state[3];
+				state[2] ^= t;
+				state[3] = rotl(state[3], 45);
+				return result;
+			}
+
+			std::uint64_t operator()() {
+				return next();
+			}
 
-			// Get a random integer between min and max
+			static constexpr std::uint64_t min() {
+				return 0;
+			}
+
+			static constexpr std::uint64_t max() {
+				return ~std::uint64_t(0);
+			}
+
+			// Get a random real in [0, 1)
+			double real() {
+				return (next() >> 11) * (1.0 / 9007199254740992.0);
+			}
+
+			// Get a random integer between min and max, inclusive
 			template< class IntType = int >
 			IntType intFromRange(IntType min, IntType max) {
-				std::uniform_int_distribution<IntType> dis(min, max);
-				return dis(generator);
+				const std::uint64_t range = std::uint64_t(max) - std::uint64_t(min) + 1;
+				if (range == 0)
+					return IntType(next());
+				// Reject the few values that would make some results more likely than others
+				const std::uint64_t threshold = (0 - range) % range;
+				std::uint64_t r;
+				do {
+					r = next();
+				} while (r < threshold);
+				return IntType(std::uint64_t(min) + r % range);
 			}
 
 			// Get a random real between min and max
 			template< class RealType = double>
 			RealType realFromRange(RealType min, RealType max) {
-				std::uniform_real_distribution<RealType> dis(min,max);
-				return dis(generator);
+				return min + RealType(real()) * (max - min);
 			}
 
 			// Has an x out of y chance of returning 'true'
 			bool chanceOutOf(unsigned int x, unsigned int y) {
 				return intFromRange(1u, y) <= x;
 			}
-			
+
 			// Has a 'chance' out of 1 chance of returning 'true'
 			bool chanceOutOf(double chance) {
-				return realFromRange(0.0, 1.0) <= chance;
+				return real() < chance;
+			}
+
+			// Get a random wait until the next of a series of events happening at random, 'rate' times per unit of time on average
+			double exponential(double rate) {
+				return -std::log(1.0 - real()) / rate;
 			}
 
+			// Fill 'out' with 'count' random reals in [0, 1)
+			void reals(double* out, std::size_t count);
+
+			// Fill 'out' with 'count' random reals between min and max
+			void realsFromRange(double* out, std::size_t count, double min, double max);
+
 		};
 
 
 	}
-}
\ No newline at end of file
+}
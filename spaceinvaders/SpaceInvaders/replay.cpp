@@ -0,0 +1,232 @@
+#include "StdAfx.h"
+#include "replay.h"
+#include "tools.h"
+
+namespace SI {
+	namespace Ctrl {
+
+		// Helper functions
+
+		// The bytes every replay file starts with, the last one being the version of the format
+		static const char replayMagic[5] = { 'S', 'I', 'R', 'P', 2 };
+
+		// The number of bits of a run's varint used for its InputState
+		static const unsigned int stateBits = MAX_INPUTNUM + 1;
+
+	// Replay::Cursor
+
+		Replay::Cursor::Cursor(const Replay& replay) : replay(&replay), offset(0), step(0), runLeft(0) {}
+
+		InputState Replay::Cursor::next() {
+			if (runLeft == 0) {
+				if (offset >= replay->data.size()) {
+					++step;
+					return InputState();
+				}
+				std::uint64_t run = readVarint(replay->data, offset);
+				runState = InputState(run & ((1u << stateBits) - 1));
+				runLeft = run >> stateBits;
+			}
+			--runLeft;
+			++step;
+			return runState;
+		}
+
+		void Replay::Cursor::seek(unsigned long long target) {
+			// Find the last keyframe at or before the target
+			const auto& keyframes = replay->keyframes;
+			auto it = std::upper_bound(keyframes.begin(), keyframes.end(), target,
+				[](unsigned long long s, const Keyframe& k) { return s < k.step; });
+
+			offset = 0;
+			step = 0;
+			runLeft = 0;
+			if (it != keyframes.begin()) {
+				--it;
+				offset = it->offset;
+				step = it->step;
+			}
+
+			// Skip whole runs until the target falls within one
+			while (step < target && offset < replay->data.size()) {
+				std::size_t runOffset = offset;
+				std::uint64_t run = readVarint(replay->data, offset);
+				unsigned long long length = run >> stateBits;
+				if (step + length > target) {
+					offset = runOffset;
+					break;
+				}
+				step += length;
+			}
+			while (step < target)
+				next();
+		}
+
+		unsigned long long Replay::Cursor::getStep() const {
+			return step;
+		}
+
+	// Replay
+
+		Replay::Replay(std::uint64_t seed, unsigned int startLevel, double stepLength, unsigned int keyframeInterval) :
+			seed(seed),
+			startLevel(startLevel),
+			stepLength(stepLength),
+			steps(0),
+			runLength(0),
+			keyframeInterval(keyframeInterval)
+		{}
+
+		void Replay::encodeRun(InputState state, unsigned long long length) {
+			unsigned long long start = steps - runLength;
+			if (keyframes.empty() || start >= keyframes.back().step + keyframeInterval)
+				keyframes.push_back({ start, data.size() });
+			writeVarint(data, (std::uint64_t(length) << stateBits) | state.to_ulong());
+		}
+
+		void Replay::append(InputState input) {
+			if (runLength && input != runState) {
+				encodeRun(runState, runLength);
+				runLength = 0;
+			}
+			runState = input;
+			++runLength;
+			++steps;
+		}
+
+		void Replay::finish() {
+			if (!runLength)
+				return;
+			encodeRun(runState, runLength);
+			runLength = 0;
+		}
+
+		void Replay::saveHeader(std::ostream& out) const {
+			std::vector<std::uint8_t> header(replayMagic, replayMagic + sizeof(replayMagic));
+			writeVarint(header, seed);
+			writeVarint(header, startLevel);
+			// The step length is stored bit for bit, little-endian
+			std::uint64_t bits;
+			std::memcpy(&bits, &stepLength, sizeof(bits));
+			for (unsigned int i = 0; i < 8; ++i)
+				header.push_back(std::uint8_t(bits >> (8 * i)));
+			out.write((const char*)header.data(), header.size());
+		}
+
+		void Replay::save(std::ostream& out) const {
+			saveHeader(out);
+			out.write((const char*)data.data(), data.size());
+		}
+
+		Replay Replay::load(std::istream& in, unsigned int keyframeInterval) {
+			std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			if (bytes.size() < sizeof(replayMagic) || !std::equal(replayMagic, replayMagic + sizeof(replayMagic), (const char*)bytes.data()))
+				throw(std::runtime_error("Not a replay, or a replay of an unsupported version."));
+
+			std::size_t offset = sizeof(replayMagic);
+			std::uint64_t seed = readVarint(bytes, offset);
+			unsigned int startLevel = (unsigned int)readVarint(bytes, offset);
+			if (offset + 8 > bytes.size())
+				throw(std::runtime_error("Replay ends in the middle of its header."));
+			std::uint64_t bits = 0;
+			for (unsigned int i = 0; i < 8; ++i)
+				bits |= std::uint64_t(bytes[offset++]) << (8 * i);
+			double stepLength;
+			std::memcpy(&stepLength, &bits, sizeof(bits));
+
+			// Re-encode the runs, which validates them and rebuilds the keyframes
+			Replay replay(seed, startLevel, stepLength, keyframeInterval);
+			replay.data.reserve(bytes.size() - offset);
+			while (offset < bytes.size()) {
+				std::uint64_t run = readVarint(bytes, offset);
+				unsigned long long length = run >> stateBits;
+				if (!length)
+					throw(std::runtime_error("Replay contains an empty run."));
+				replay.steps += length;
+				replay.runLength = length;
+				replay.encodeRun(InputState(run & ((1u << stateBits) - 1)), length);
+			}
+			replay.runLength = 0;
+			return replay;
+		}
+
+		std::uint64_t Replay::getSeed() const {
+			return seed;
+		}
+
+		unsigned int Replay::getStartLevel() const {
+			return startLevel;
+		}
+
+		double Replay::getStepLength() const {
+			return stepLength;
+		}
+
+		unsigned long long Replay::getSteps() const {
+			return steps;
+		}
+
+		const std::vector<std::uint8_t>& Replay::getData() const {
+			return data;
+		}
+
+		const std::vector<Replay::Keyframe>& Replay::getKeyframes() const {
+			return keyframes;
+		}
+
+	// RecordingInput : public InputSource
+
+		RecordingInput::RecordingInput(std::shared_ptr<InputSource> source, std::shared_ptr<Replay> replay, std::string path) :
+			source(source), replay(replay), written(0)
+		{
+			if (path.empty())
+				return;
+			file.open(path, std::ios::binary);
+			if (!file)
+				throw(std::runtime_error("Failed to open replay file: " + path));
+			replay->save(file);
+			written = replay->getData().size();
+			file.flush();
+		}
+
+		RecordingInput::~RecordingInput() {
+			replay->finish();
+			flush();
+		}
+
+		void RecordingInput::flush() {
+			if (!file.is_open())
+				return;
+			const std::vector<std::uint8_t>& data = replay->getData();
+			if (data.size() == written)
+				return;
+			file.write((const char*)data.data() + written, data.size() - written);
+			file.flush();
+			written = data.size();
+		}
+
+		InputState RecordingInput::getInput() {
+			InputState input = source->getInput();
+			replay->append(input);
+			flush();
+			return input;
+		}
+
+		std::shared_ptr<Replay> RecordingInput::getReplay() const {
+			return replay;
+		}
+
+	// ReplayInput : public InputSource
+
+		ReplayInput::ReplayInput(std::shared_ptr<const Replay> replay) : replay(replay), cursor(*replay) {}
+
+		InputState ReplayInput::getInput() {
+			return cursor.next();
+		}
+
+		void ReplayInput::seek(unsigned long long step) {
+			cursor.seek(step);
+		}
+
+	}
+}
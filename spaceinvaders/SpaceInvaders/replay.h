@@ -0,0 +1,169 @@
+#pragma once
+#include "StdAfx.h"
+#include "input.h"
+
+namespace SI {
+	namespace Ctrl {
+
+		// A recording of the input of a single game, along with everything needed to play it back exactly:
+		// the seed of the model's RNG, the level it started at and the length of its steps
+		// The input is stored as runs of identical InputStates, each encoded as a single varint holding both
+		// the length of the run and the state, so held or idle input costs next to nothing
+		class Replay {
+		public:
+			// A point in the encoded input where a run starts, from which decoding can resume
+			struct Keyframe {
+				// The step the run starts at
+				unsigned long long step;
+
+				// The offset of the run in the encoded input
+				std::size_t offset;
+			};
+
+			// Reads the input of a replay back one step at a time
+			class Cursor {
+			private:
+				// The replay being read
+				const Replay* replay;
+
+				// The offset of the next run in the encoded input
+				std::size_t offset;
+
+				// The step the next call to next() returns the input of
+				unsigned long long step;
+
+				// The number of steps left in the current run, and its state
+				unsigned long long runLeft;
+				InputState runState;
+
+			public:
+				Cursor(const Replay& replay);
+
+				// Get the input of the current step and move on to the next step
+				// Returns an empty InputState past the end of the replay
+				InputState next();
+
+				// Move to the given step, decoding from the closest keyframe before it
+				void seek(unsigned long long step);
+
+				// Get the step the next call to next() returns the input of
+				unsigned long long getStep() const;
+			};
+
+		private:
+			// The seed of the model's RNG
+			std::uint64_t seed;
+
+			// The level the game started at
+			unsigned int startLevel;
+
+			// The length of the model's steps in seconds
+			double stepLength;
+
+			// The encoded runs of input
+			std::vector<std::uint8_t> data;
+
+			// The number of steps recorded, including the run that hasn't been encoded yet
+			unsigned long long steps;
+
+			// The run that is being recorded, only encoded once the input changes or the recording is finished
+			InputState runState;
+			unsigned long long runLength;
+
+			// The minimum number of steps between keyframes
+			unsigned int keyframeInterval;
+
+			// The keyframes, in order of their steps
+			std::vector<Keyframe> keyframes;
+
+			// Encode a run, adding a keyframe if it's been long enough since the last one
+			void encodeRun(InputState state, unsigned long long length);
+
+			// Write the header of the replay to a stream
+			void saveHeader(std::ostream& out) const;
+
+		public:
+			Replay(std::uint64_t seed, unsigned int startLevel, double stepLength, unsigned int keyframeInterval = 1200);
+
+			// Record the input of the next step
+			void append(InputState input);
+
+			// Encode the run that is being recorded, has to be called before the last steps can be read or saved
+			void finish();
+
+			// Write the replay to a stream, only the part which has been encoded so far
+			void save(std::ostream& out) const;
+
+			// Read a replay from a stream
+			static Replay load(std::istream& in, unsigned int keyframeInterval = 1200);
+
+			// Get the seed of the model's RNG
+			std::uint64_t getSeed() const;
+
+			// Get the level the game started at
+			unsigned int getStartLevel() const;
+
+			// Get the length of the model's steps in seconds
+			double getStepLength() const;
+
+			// Get the number of steps recorded
+			unsigned long long getSteps() const;
+
+			// Get the encoded input
+			const std::vector<std::uint8_t>& getData() const;
+
+			// Get the keyframes
+			const std::vector<Keyframe>& getKeyframes() const;
+		};
+
+		// An InputSource which passes on the input of another InputSource, recording it into a Replay
+		// Can stream the replay into a file as it's being recorded, so that a session which ends abruptly isn't lost
+		class RecordingInput : public InputSource {
+		private:
+			// The source being recorded
+			std::shared_ptr<InputSource> source;
+
+			// The recording
+			std::shared_ptr<Replay> replay;
+
+			// The file the recording is streamed to, if any
+			std::ofstream file;
+
+			// The number of bytes of encoded input written to the file
+			std::size_t written;
+
+			// Write any newly encoded input to the file
+			void flush();
+
+		public:
+			RecordingInput(std::shared_ptr<InputSource> source, std::shared_ptr<Replay> replay, std::string path = "");
+			~RecordingInput();
+
+			// Returns and records the input of the source
+			virtual InputState getInput();
+
+			// Get the recording
+			std::shared_ptr<Replay> getReplay() const;
+		};
+
+		// An InputSource playing back the input of a Replay
+		class ReplayInput : public InputSource {
+		private:
+			// The replay being played back
+			std::shared_ptr<const Replay> replay;
+
+			// The position in the replay
+			Replay::Cursor cursor;
+
+		public:
+			ReplayInput(std::shared_ptr<const Replay> replay);
+
+			// Returns the input of the next step of the replay
+			virtual InputState getInput();
+
+			// Move to the given step of the replay
+			void seek(unsigned long long step);
+		};
+
+	}
+}
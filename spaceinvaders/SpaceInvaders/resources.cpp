@@ -101,6 +101,10 @@ namespace SI {
 			return font8BitOperator;
 		}
 
+		const sf::Texture& Resources::getSpriteSheetTexture() const {
+			return spriteSheetTexture;
+		}
+
 		sf::Sprite & Resources::getBackgroundSprite(){
 			return backgroundSprite;
 		}
@@ -1,5 +1,7 @@
 #pragma once
 #include "StdAfx.h"
+#include <SFML/Graphics.hpp>
+#include <SFML/Audio.hpp>
 #include "time.h"
 
 namespace SI {
@@ -14,6 +16,10 @@ namespace SI {
 			// Fonts:
 			sf::Font& getFont();
 
+			// Textures:
+			// The texture every entity and HUD sprite is cut out of
+			const sf::Texture& getSpriteSheetTexture() const;
+
 			// Sprites:
 			sf::Sprite& getBackgroundSprite();
 			sf::Sprite& getPauseOverlaySprite();
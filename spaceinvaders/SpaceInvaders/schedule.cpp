@@ -0,0 +1,64 @@
+#include "StdAfx.h"
+#include "schedule.h"
+
+namespace SI {
+	namespace Md {
+
+		// Helper functions
+
+		// Order shots so that the earliest one ends up on top of the heap
+		static bool later(const ShotSchedule::Shot& a, const ShotSchedule::Shot& b) {
+			return a.time > b.time;
+		}
+
+		// Get the time point 'seconds' after 'time'
+		static TimePoint after(TimePoint time, double seconds) {
+			return time + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(seconds));
+		}
+
+	// ShotSchedule
+
+		ShotSchedule::ShotSchedule(double rate, std::shared_ptr<Time::Stopwatch> stopwatch) :
+			stopwatch(stopwatch), rate(rate) {}
+
+		void ShotSchedule::reserve(unsigned int count) {
+			shots.reserve(count);
+		}
+
+		void ShotSchedule::clear() {
+			shots.clear();
+		}
+
+		void ShotSchedule::schedule(EntityHandle handle, EntityType type, RNG::RNG& rng) {
+			shots.push_back({ after(stopwatch->now(), rng.exponential(rate)), handle, type });
+			std::push_heap(shots.begin(), shots.end(), later);
+		}
+
+		void ShotSchedule::scheduleAfter(const Shot& shot, RNG::RNG& rng) {
+			shots.push_back({ after(shot.time, rng.exponential(rate)), shot.handle, shot.type });
+			std::push_heap(shots.begin(), shots.end(), later);
+		}
+
+		bool ShotSchedule::popDue(Shot& out) {
+			if (shots.empty() || shots.front().time > stopwatch->now())
+				return false;
+			std::pop_heap(shots.begin(), shots.end(), later);
+			out = shots.back();
+			shots.pop_back();
+			return true;
+		}
+
+		unsigned int ShotSchedule::count() const {
+			return shots.size();
+		}
+
+		void ShotSchedule::save(Snapshot& out) const {
+			out.writeVector(shots);
+		}
+
+		void ShotSchedule::load(Snapshot::Reader& in) {
+			in.readVector(shots);
+		}
+
+	}
+}
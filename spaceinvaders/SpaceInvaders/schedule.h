@@ -0,0 +1,69 @@
+#pragma once
+
+#include "StdAfx.h"
+#include "observer.h"
+#include "snapshot.h"
+#include "time.h"
+#include "random.h"
+
+namespace SI {
+	namespace Md {
+
+		// The moments at which every enemy fires its next shot, kept as a queue with the earliest shot on top
+		// Each enemy fires at random moments at the same average rate, so the waits between its shots are exponentially
+		// distributed: only the enemies whose shots are due have to be looked at, rather than rolling for every enemy every step
+		class ShotSchedule {
+		public:
+			// A single scheduled shot
+			struct Shot {
+				// The moment the shot is fired, by the schedule's stopwatch
+				TimePoint time;
+
+				// The enemy firing the shot
+				EntityHandle handle;
+
+				// The type of the enemy firing the shot
+				EntityType type;
+			};
+
+		private:
+			// The stopwatch deciding which shots are due
+			std::shared_ptr<Time::Stopwatch> stopwatch;
+
+			// The average number of shots an enemy fires per second
+			double rate;
+
+			// The scheduled shots, as a binary heap with the earliest shot first
+			std::vector<Shot> shots;
+
+		public:
+			ShotSchedule(double rate, std::shared_ptr<Time::Stopwatch> stopwatch);
+
+			// Make room for the shots of at least 'count' enemies
+			void reserve(unsigned int count);
+
+			// Remove every scheduled shot
+			void clear();
+
+			// Schedule the first shot of an enemy, some random time from now
+			void schedule(EntityHandle handle, EntityType type, RNG::RNG& rng);
+
+			// Schedule the shot of an enemy following the given shot, some random time after it
+			void scheduleAfter(const Shot& shot, RNG::RNG& rng);
+
+			// Take the earliest shot into 'out' if it is due, returns false if no shot is due
+			// Shots of enemies that have been removed in the meantime are taken as well, and should be dropped
+			bool popDue(Shot& out);
+
+			// Get the number of scheduled shots
+			unsigned int count() const;
+
+			// Write the state to a snapshot
+			void save(Snapshot& out) const;
+
+			// Read the state back from a snapshot
+			void load(Snapshot::Reader& in);
+		};
+
+	}
+}
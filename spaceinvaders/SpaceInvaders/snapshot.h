@@ -0,0 +1,98 @@
+#pragma once
+
+#include "StdAfx.h"
+
+namespace SI {
+
+	// A flat buffer holding the complete state of a simulation, as plain bytes copied straight out of its members
+	// Values are read back in the exact order they were written, there is no further structure
+	// Clearing and rewriting a snapshot reuses its storage, so taking snapshots in a loop doesn't allocate
+	class Snapshot {
+	private:
+		std::vector<std::uint8_t> data;
+
+		// Append 'count' raw bytes
+		void append(const void* bytes, std::size_t count) {
+			std::size_t offset = data.size();
+			data.resize(offset + count);
+			if (count)
+				std::memcpy(&data[offset], bytes, count);
+		}
+
+	public:
+		// Reads the values of a snapshot back in order
+		class Reader {
+		private:
+			const Snapshot& snapshot;
+			std::size_t offset;
+
+			// Copy the next 'count' raw bytes into 'bytes'
+			void take(void* bytes, std::size_t count) {
+				if (offset + count > snapshot.data.size())
+					throw(std::runtime_error("Snapshot ends before everything has been read from it."));
+				if (count)
+					std::memcpy(bytes, &snapshot.data[offset], count);
+				offset += count;
+			}
+
+		public:
+			Reader(const Snapshot& snapshot) : snapshot(snapshot), offset(0) {}
+
+			// Read a single value
+			template <typename T>
+			void read(T& value) {
+				static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read from a snapshot.");
+				take(&value, sizeof(T));
+			}
+
+			// Read a vector, reusing its storage
+			template <typename T>
+			void readVector(std::vector<T>& values) {
+				static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read from a snapshot.");
+				std::uint32_t size;
+				read(size);
+				values.resize(size);
+				take(values.data(), size * sizeof(T));
+			}
+
+			// Check whether or not everything has been read
+			bool atEnd() const {
+				return offset == snapshot.data.size();
+			}
+		};
+
+		// Remove every value, keeping the storage
+		void clear() {
+			data.clear();
+		}
+
+		// Write a single value
+		template <typename T>
+		void write(const T& value) {
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written to a snapshot.");
+			append(&value, sizeof(T));
+		}
+
+		// Write a vector
+		template <typename T>
+		void writeVector(const std::vector<T>& values) {
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written to a snapshot.");
+			write((std::uint32_t)values.size());
+			append(values.data(), values.size() * sizeof(T));
+		}
+
+		// Get the size of the snapshot in bytes
+		std::size_t size() const {
+			return data.size();
+		}
+
+		// Get a 64-bit FNV-1a hash of the snapshot, so that states can be compared cheaply
+		std::uint64_t checksum() const {
+			std::uint64_t hash = 0xCBF29CE484222325ull;
+			for (std::uint8_t byte : data)
+				hash = (hash ^ byte) * 0x100000001B3ull;
+			return hash;
+		}
+	};
+
+}
@@ -0,0 +1,84 @@
+#include "StdAfx.h"
+#include "stats.h"
+
+namespace SI {
+	namespace Md {
+
+		StatsObserver::StatsObserver() :
+			levelsCompleted(0),
+			secondsPassed(0),
+			lives(0),
+			state(ModelState::running),
+			events(nullptr)
+		{
+			eventCounts.fill(0);
+		}
+
+		std::string StatsObserver::getLevelName() const {
+			return levelName;
+		}
+
+		unsigned int StatsObserver::getLevelsCompleted() const {
+			return levelsCompleted;
+		}
+
+		unsigned int StatsObserver::getSecondsPassed() const {
+			return secondsPassed;
+		}
+
+		int StatsObserver::getLives() const {
+			return lives;
+		}
+
+		ModelState StatsObserver::getState() const {
+			return state;
+		}
+
+		bool StatsObserver::isFinished() const {
+			return state == ModelState::gameOver || state == ModelState::victory;
+		}
+
+		unsigned int StatsObserver::getEventCount(EventType type) const {
+			return eventCounts[type];
+		}
+
+		unsigned int StatsObserver::getEnemiesDestroyed() const {
+			return eventCounts[smallEnemyDestroyed] + eventCounts[bigEnemyDestroyed];
+		}
+
+		void StatsObserver::updateLevelName(std::string levelName) {
+			this->levelName = levelName;
+		}
+
+		void StatsObserver::updateSecondsPassed(unsigned int secondsPassed) {
+			this->secondsPassed = secondsPassed;
+		}
+
+		void StatsObserver::updateLives(int lives) {
+			this->lives = lives;
+		}
+
+		void StatsObserver::updateState(ModelState state) {
+			// Completing the last level goes straight to victory, every other level passes through levelSwitch
+			if ((state == ModelState::levelSwitch || state == ModelState::victory) && state != this->state)
+				++levelsCompleted;
+			this->state = state;
+		}
+
+		void StatsObserver::updateEvents(const EventRing& events) {
+			if (this->events != &events) {
+				this->events = &events;
+				eventCursor = events.end();
+			}
+			while (const Event* event = events.next(eventCursor))
+				++eventCounts[event->getType()];
+		}
+
+		// None of the following are tallied
+		void StatsObserver::updatePlayerInvinc(unsigned int, bool) {}
+		void StatsObserver::updatePlayerDead(unsigned int, bool) {}
+		void StatsObserver::updateEntityCount(unsigned int) {}
+		void StatsObserver::updateEntities(EntitySpan) {}
+
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "StdAfx.h"
+#include "observer.h"
+
+namespace SI {
+	namespace Md {
+
+		// A ModelObserver which only tallies up how a game went, without keeping track of any entities
+		// Meant for running games without a view
+		class StatsObserver : public ModelObserver {
+		private:
+			// The name of the current level
+			std::string levelName;
+
+			// The number of levels completed
+			unsigned int levelsCompleted;
+
+			// The number of seconds that have passed since the start of the level
+			unsigned int secondsPassed;
+
+			// The number of lives the player has
+			int lives;
+
+			// The state of the model
+			ModelState state;
+
+			// The number of times each type of event has happened
+			std::array<unsigned int, eventTypeCount> eventCounts;
+
+			// The position up to which the model's events have been tallied
+			EventRing::Cursor eventCursor;
+
+			// The model's ring of events the cursor reads, to tell when it changes
+			const EventRing* events;
+
+		public:
+			StatsObserver();
+
+			// Get the name of the current level
+			std::string getLevelName() const;
+
+			// Get the number of levels completed
+			unsigned int getLevelsCompleted() const;
+
+			// Get the number of seconds that have passed since the start of the level
+			unsigned int getSecondsPassed() const;
+
+			// Get the number of lives the player has
+			int getLives() const;
+
+			// Get the state of the model
+			ModelState getState() const;
+
+			// Check whether or not the game has ended, in either victory or game over
+			bool isFinished() const;
+
+			// Get the number of times a type of event has happened
+			unsigned int getEventCount(EventType type) const;
+
+			// Get the number of enemies destroyed
+			unsigned int getEnemiesDestroyed() const;
+
+			virtual void updateLevelName(std::string levelName);
+			virtual void updateSecondsPassed(unsigned int secondsPassed);
+			virtual void updateLives(int lives);
+			virtual void updateState(ModelState state);
+			virtual void updatePlayerInvinc(unsigned int player, bool playerInvinc);
+			virtual void updatePlayerDead(unsigned int player, bool playerDead);
+			virtual void updateEntityCount(unsigned int entityCount);
+			virtual void updateEvents(const EventRing& events);
+			virtual void updateEntities(EntitySpan entities);
+		};
+
+	}
+}
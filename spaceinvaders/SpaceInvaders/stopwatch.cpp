@@ -15,24 +15,45 @@ namespace SI
 
 		Stopwatch::Stopwatch() : lastTick(std::chrono::seconds(0)) {}
 
-	// GlobalStopwatch : public Stopwatch
+		TimerWheel& Stopwatch::getTimers() {
+			return timers;
+		}
 
-		// private:	
-			// static data member:
-		std::shared_ptr<GlobalStopwatch> GlobalStopwatch::stopwatch;
+		void Stopwatch::updateTimers() {
+			timers.advance(now());
+		}
+
+	// GlobalStopwatch : public Stopwatch
 
-		GlobalStopwatch::GlobalStopwatch() : Stopwatch(){}
+		GlobalStopwatch::GlobalStopwatch() : Stopwatch(), clock(std::make_shared<SystemClock>()), offset(0), sampled(clock->now()) {}
 
 		// public:
 		std::shared_ptr<GlobalStopwatch> GlobalStopwatch::getInstance() {
-			if (!stopwatch) {
-				stopwatch = std::shared_ptr<GlobalStopwatch>(new GlobalStopwatch);
-			}
+			// Initialising a local static is thread safe
+			static std::shared_ptr<GlobalStopwatch> stopwatch(new GlobalStopwatch);
 			return stopwatch;
 		}
 
+		void GlobalStopwatch::sample() {
+			sampled = read();
+			updateTimers();
+		}
+
+		std::shared_ptr<Clock> GlobalStopwatch::getClock() const {
+			return clock;
+		}
+
+		void GlobalStopwatch::setClock(std::shared_ptr<Clock> clock) {
+			this->clock = clock;
+			offset = sampled - clock->now();
+		}
+
 		TimePoint GlobalStopwatch::now() const {
-			return std::chrono::high_resolution_clock::now();
+			return sampled;
+		}
+
+		TimePoint GlobalStopwatch::read() const {
+			return clock->now() + offset;
 		}
 
 		double GlobalStopwatch::tick() {
@@ -47,17 +68,63 @@ namespace SI
 			return out;
 		}
 
+		void Stopwatch::save(Snapshot& out) const {
+			out.write(lastTick);
+		}
+
+		void Stopwatch::load(Snapshot::Reader& in) {
+			in.read(lastTick);
+		}
+
+	// ManualStopwatch : public Stopwatch
+
+		// Start at one second past the epoch, since a zero time point marks a stopwatch that hasn't ticked yet
+		ManualStopwatch::ManualStopwatch() : Stopwatch(), current(std::chrono::seconds(1)) {}
+
+		void ManualStopwatch::advance(double seconds) {
+			current += std::chrono::nanoseconds((long long)std::llround(seconds * 1e9));
+			updateTimers();
+		}
+
+		TimePoint ManualStopwatch::now() const {
+			return current;
+		}
+
+		double ManualStopwatch::tick() {
+			if (!lastTick.time_since_epoch().count()) {
+				lastTick = current;
+				return 0;
+			}
+			double out = nanoToSeconds(current - lastTick);
+			lastTick = current;
+			return out;
+		}
+
+		void ManualStopwatch::save(Snapshot& out) const {
+			Stopwatch::save(out);
+			out.write(current);
+		}
+
+		void ManualStopwatch::load(Snapshot::Reader& in) {
+			Stopwatch::load(in);
+			in.read(current);
+			// Time may have moved backwards
+			timers.reset(now());
+		}
+
 	// SimStopwatch
 
-		SimStopwatch::SimStopwatch() : globalStopwatch(GlobalStopwatch::getInstance()), paused(false), pauseAdjust(0) {}
+		SimStopwatch::SimStopwatch(std::shared_ptr<Stopwatch> source) : source(source), paused(false), pauseAdjust(0) {}
 
 		TimePoint SimStopwatch::now() const {
 			if (paused)
 				return (pauseTime - pauseAdjust);
-			return (globalStopwatch->now() - pauseAdjust);
+			return (source->now() - pauseAdjust);
 		}
 
 		double SimStopwatch::tick() {
+			updateTimers();
+
 			// No tick length while paused
 			if (paused)
 				return 0;
@@ -83,7 +150,7 @@ namespace SI
 				return;
 
 			paused = true;
-			pauseTime = globalStopwatch->now();
+			pauseTime = source->now();
 		}
 
 		void SimStopwatch::unPause() {
@@ -92,7 +159,23 @@ namespace SI
 				return;
 
 			paused = false;
-			pauseAdjust += (globalStopwatch->now() - pauseTime);
+			pauseAdjust += (source->now() - pauseTime);
+		}
+
+		void SimStopwatch::save(Snapshot& out) const {
+			Stopwatch::save(out);
+			out.write(paused);
+			out.write(pauseTime);
+			out.write(pauseAdjust);
+		}
+
+		void SimStopwatch::load(Snapshot::Reader& in) {
+			Stopwatch::load(in);
+			in.read(paused);
+			in.read(pauseTime);
+			in.read(pauseAdjust);
+			// Time may have moved backwards
+			timers.reset(now());
 		}
 	}
 }
\ No newline at end of file
@@ -1,8 +1,9 @@
 #pragma once
 
 #include "StdAfx.h"
-
-typedef std::chrono::time_point<std::chrono::high_resolution_clock> TimePoint;
+#include "snapshot.h"
+#include "wheel.h"
+#include "clock.h"
 
 namespace SI
 {
@@ -22,41 +23,105 @@ namespace SI
 			// Data members
 			TimePoint lastTick;
 
+			// The wheel the timers based on the stopwatch register their deadlines with
+			TimerWheel timers;
+
 		public:
 			Stopwatch();
 			virtual double tick() = 0;
 			virtual TimePoint now() const = 0;
 
+			// Get the wheel the timers based on the stopwatch register their deadlines with
+			TimerWheel& getTimers();
+
+			// Expire the timers whose deadline has passed by now, the timers only see time pass when this is called
+			// Stopwatches advanced by hand or ticked by the simulation call it themselves, the GlobalStopwatch when sampled
+			void updateTimers();
+
+			// Write the state to a snapshot
+			virtual void save(Snapshot& out) const;
+
+			// Read the state back from a snapshot
+			virtual void load(Snapshot::Reader& in);
+
 		};
 
 		class GlobalStopwatch;
 
 		// A stopwatch based off the computer's internal clock
 		// Can only be instantiated once, cannot be paused or altered
+		// The clock is read once every sample, and every user of the stopwatch sees that same time until the next one,
+		// so a frame reads the clock once rather than for every timer, counter and particle
 		class GlobalStopwatch : public Stopwatch {
 		private:
-			// Data members
-			static std::shared_ptr<GlobalStopwatch> stopwatch;
+			// The clock the time is read from
+			std::shared_ptr<Clock> clock;
+
+			// The difference between the stopwatch's time and the clock's, so that time carries on when the clock is changed
+			std::chrono::nanoseconds offset;
+
+			// The time read at the last sample
+			TimePoint sampled;
 
 			// Functions
 			GlobalStopwatch();
 
 		public:
+			// Get the only instance, creating it on first use, from any thread
 			static std::shared_ptr<GlobalStopwatch> getInstance();
 
+			// Read the clock, giving the time everyone sees until the next sample, and update the timers
+			void sample();
+
+			// Get the clock the time is read from
+			std::shared_ptr<Clock> getClock() const;
+
+			// Read the time from another clock from now on, carrying on from the last sample
+			void setClock(std::shared_ptr<Clock> clock);
+
 			// Get the amount of time since last tick() call
 			double tick();
 
-			// Get the current time point in real time
+			// Get the time point in real time of the last sample
 			TimePoint now() const;
+
+			// Read the clock right away without sampling it, for threads other than the one sampling the stopwatch
+			TimePoint read() const;
 		};
 
 
+		// A stopwatch whose time only moves forward when told to
+		// Used to drive a simulation in exact steps, independent of the computer's clock
+		class ManualStopwatch : public Stopwatch {
+		private:
+			// The current time point
+			TimePoint current;
+
+		public:
+			ManualStopwatch();
+
+			// Move the current time forward by a number of seconds, updating the timers
+			void advance(double seconds);
+
+			// Get the amount of time since last tick() call
+			double tick();
+
+			// Get the current time point
+			TimePoint now() const;
+
+			// Write the state to a snapshot
+			virtual void save(Snapshot& out) const;
+
+			// Read the state back from a snapshot
+			virtual void load(Snapshot::Reader& in);
+		};
+
 		// A Stopwatch designed for a simulation to use,
 		// Can have multiple instances, can be paused
 		class SimStopwatch : public Stopwatch {
 		private:
-			std::shared_ptr<GlobalStopwatch> globalStopwatch;
+			// The stopwatch the time is based on
+			std::shared_ptr<Stopwatch> source;
 
 			// Whether the stopwatch is paused or not
 			bool paused;
@@ -68,9 +133,10 @@ namespace SI
 			std::chrono::nanoseconds pauseAdjust;
 
 		public:
-			SimStopwatch();
+			SimStopwatch(std::shared_ptr<Stopwatch> source = GlobalStopwatch::getInstance());
 
-			// Get the amount of time since last tick() call, adjusted by the model's pausedness
+			// Get the amount of time since last tick() call, adjusted by the model's pausedness, and update the timers
+			// While paused the time stands still, and so do the timers
 			double tick();
 
 			// Get the current time point, adjusted by the model's pausedness
@@ -85,6 +151,12 @@ namespace SI
 			// Unpause the stopwatch
 			void unPause();
 
+			// Write the state to a snapshot
+			virtual void save(Snapshot& out) const;
+
+			// Read the state back from a snapshot
+			virtual void load(Snapshot::Reader& in);
+
 		};
 
 	}
@@ -0,0 +1,285 @@
+#include "StdAfx.h"
+#include "store.h"
+
+namespace SI {
+	namespace Md {
+
+		// The names of the EntityTypes, used when logging
+		static const char* entityTypeNames[entityTypeCount] = {
+			"player", "smallEnemy", "bigEnemy", "playerBullet", "enemyBullet", "barrier", "powerup"
+		};
+
+		// EntityArray
+
+		EntityArray::EntityArray() : type(player), capacity(0), highWaterMark(0), originX(0), originY(0) {}
+
+		unsigned int EntityArray::count() const {
+			return x.size();
+		}
+
+		void EntityArray::reserve(unsigned int capacity) {
+			if (capacity <= this->capacity)
+				return;
+			this->capacity = capacity;
+			x.reserve(capacity);
+			y.reserve(capacity);
+			xvel.reserve(capacity);
+			yvel.reserve(capacity);
+			xacc.reserve(capacity);
+			yacc.reserve(capacity);
+			size.reserve(capacity);
+			health.reserve(capacity);
+			removed.reserve(capacity);
+			removals.reserve(capacity);
+			handle.reserve(capacity);
+		}
+
+		unsigned int EntityArray::add(EntityHandle handle, double x, double y, float size, int health, double xvel, double yvel, double xacc, double yacc) {
+			if (count() == capacity) {
+				unsigned int grown = std::max(16u, capacity * 2);
+				std::cout << "Warning: " << entityTypeNames[type] << " array full at " << capacity << " entities, growing to " << grown << "." << std::endl;
+				reserve(grown);
+			}
+			this->x.push_back(x - originX);
+			this->y.push_back(y - originY);
+			this->xvel.push_back(xvel);
+			this->yvel.push_back(yvel);
+			this->xacc.push_back(xacc);
+			this->yacc.push_back(yacc);
+			this->size.push_back(size);
+			this->health.push_back(health);
+			removed.push_back(false);
+			this->handle.push_back(handle);
+			highWaterMark = std::max(highWaterMark, count());
+			return count() - 1;
+		}
+
+		void EntityArray::save(Snapshot& out) const {
+			out.write(originX);
+			out.write(originY);
+			out.writeVector(x);
+			out.writeVector(y);
+			out.writeVector(xvel);
+			out.writeVector(yvel);
+			out.writeVector(xacc);
+			out.writeVector(yacc);
+			out.writeVector(size);
+			out.writeVector(health);
+			out.writeVector(removed);
+			out.writeVector(removals);
+			out.writeVector(handle);
+		}
+
+		void EntityArray::load(Snapshot::Reader& in) {
+			in.read(originX);
+			in.read(originY);
+			in.readVector(x);
+			in.readVector(y);
+			in.readVector(xvel);
+			in.readVector(yvel);
+			in.readVector(xacc);
+			in.readVector(yacc);
+			in.readVector(size);
+			in.readVector(health);
+			in.readVector(removed);
+			in.readVector(removals);
+			in.readVector(handle);
+			// Loading may have grown the arrays past what was reserved
+			reserve(count());
+			highWaterMark = std::max(highWaterMark, count());
+		}
+
+		bool EntityArray::remove(unsigned int i) {
+			if (removed[i])
+				return false;
+			removed[i] = true;
+			removals.push_back(i);
+			return true;
+		}
+
+		bool EntityArray::isRemoved(unsigned int i) const {
+			return removed[i] != 0;
+		}
+
+		// Drop the elements of a vector whose flag is set, preserving the order of the rest
+		template <typename T>
+		static void compactVector(std::vector<T>& v, const std::vector<char>& flags) {
+			unsigned int w = 0;
+			for (unsigned int r = 0; r < v.size(); ++r)
+				if (!flags[r]) {
+					if (w != r)
+						v[w] = std::move(v[r]);
+					++w;
+				}
+			v.resize(w);
+		}
+
+		void EntityArray::compact() {
+			if (removals.empty())
+				return;
+			compactVector(x, removed);
+			compactVector(y, removed);
+			compactVector(xvel, removed);
+			compactVector(yvel, removed);
+			compactVector(xacc, removed);
+			compactVector(yacc, removed);
+			compactVector(size, removed);
+			compactVector(health, removed);
+			compactVector(handle, removed);
+			removed.assign(x.size(), false);
+			removals.clear();
+		}
+
+		void EntityArray::clear() {
+			x.clear();
+			y.clear();
+			xvel.clear();
+			yvel.clear();
+			xacc.clear();
+			yacc.clear();
+			size.clear();
+			health.clear();
+			removed.clear();
+			removals.clear();
+			handle.clear();
+		}
+
+		double EntityArray::worldX(unsigned int i) const {
+			return originX + x[i];
+		}
+
+		double EntityArray::worldY(unsigned int i) const {
+			return originY + y[i];
+		}
+
+		void EntityArray::setOrigin(double x, double y) {
+			originX = x;
+			originY = y;
+		}
+
+		bool EntityArray::isDead(unsigned int i) const {
+			return health[i] <= 0;
+		}
+
+		// EntityStore
+
+		EntityStore::EntityStore() {
+			for (unsigned int t = 0; t < entityTypeCount; ++t)
+				arrays[t].type = (EntityType)t;
+		}
+
+		void EntityStore::reserve(EntityType type, unsigned int capacity) {
+			arrays[type].reserve(capacity);
+			unsigned int total = 0;
+			for (auto& a : arrays)
+				total += a.capacity;
+			slots.reserve(total);
+			freeSlots.reserve(total);
+		}
+
+		void EntityStore::freeSlot(EntityHandle handle) {
+			Slot& slot = slots[handle.getSlot()];
+			slot.used = 0;
+			slot.generation++;
+			freeSlots.push_back(handle.getSlot());
+		}
+
+		EntityHandle EntityStore::add(EntityType type, double x, double y, float size, int health, double xvel, double yvel, double xacc, double yacc) {
+			std::uint32_t s;
+			if (!freeSlots.empty()) {
+				s = freeSlots.back();
+				freeSlots.pop_back();
+			} else {
+				if (slots.size() == EntityHandle::maxSlots)
+					throw(std::runtime_error("Exceeded the maximum number of entities."));
+				s = slots.size();
+				slots.push_back(Slot{ type, 0, 0, 0 });
+			}
+
+			Slot& slot = slots[s];
+			EntityHandle handle(s, slot.generation);
+			slot.type = type;
+			slot.index = arrays[type].add(handle, x, y, size, health, xvel, yvel, xacc, yacc);
+			slot.used = 1;
+			return handle;
+		}
+
+		bool EntityStore::isValid(EntityHandle handle) const {
+			if (handle.isNull() || handle.getSlot() >= slots.size())
+				return false;
+			const Slot& slot = slots[handle.getSlot()];
+			return slot.used && EntityHandle(handle.getSlot(), slot.generation) == handle;
+		}
+
+		EntityType EntityStore::getType(EntityHandle handle) const {
+			if (!isValid(handle))
+				throw(std::runtime_error("Attempted to look up an entity using a stale handle."));
+			return slots[handle.getSlot()].type;
+		}
+
+		unsigned int EntityStore::getIndex(EntityHandle handle) const {
+			if (!isValid(handle))
+				throw(std::runtime_error("Attempted to look up an entity using a stale handle."));
+			return slots[handle.getSlot()].index;
+		}
+
+		void EntityStore::compact() {
+			for (auto& a : arrays) {
+				if (a.removals.empty())
+					continue;
+				for (unsigned int i : a.removals)
+					freeSlot(a.handle[i]);
+				a.compact();
+				// The remaining entities may have moved
+				for (unsigned int i = 0; i < a.count(); ++i)
+					slots[a.handle[i].getSlot()].index = i;
+			}
+		}
+
+		EntityArray& EntityStore::operator[](EntityType type) {
+			return arrays[type];
+		}
+
+		const EntityArray& EntityStore::operator[](EntityType type) const {
+			return arrays[type];
+		}
+
+		unsigned int EntityStore::count() const {
+			unsigned int out = 0;
+			for (auto& a : arrays)
+				out += a.count();
+			return out;
+		}
+
+		void EntityStore::observe(std::vector<EntityObserver>& out) const {
+			out.clear();
+			for (auto& a : arrays)
+				for (unsigned int i = 0; i < a.count(); ++i)
+					if (!a.removed[i])
+						out.push_back(EntityObserver(a.handle[i], a.type, a.originX + a.x[i], a.originY + a.y[i], a.health[i]));
+		}
+
+		void EntityStore::save(Snapshot& out) const {
+			for (auto& a : arrays)
+				a.save(out);
+			out.writeVector(slots);
+			out.writeVector(freeSlots);
+		}
+
+		void EntityStore::load(Snapshot::Reader& in) {
+			for (auto& a : arrays)
+				a.load(in);
+			in.readVector(slots);
+			in.readVector(freeSlots);
+		}
+
+		void EntityStore::clear() {
+			for (auto& a : arrays) {
+				for (auto& h : a.handle)
+					freeSlot(h);
+				a.clear();
+			}
+		}
+
+	}
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "StdAfx.h"
+#include "observer.h"
+#include "snapshot.h"
+
+namespace SI {
+	namespace Md {
+
+		// A contiguous, structure-of-arrays collection of every entity of one EntityType
+		// Entity i is described by the i'th element of each array
+		struct EntityArray {
+			// The type of the entities in the array
+			EntityType type;
+
+			// The number of entities the array has room for without allocating
+			unsigned int capacity;
+
+			// The largest number of entities the array has held at once
+			unsigned int highWaterMark;
+
+			// The point the entities' coordinates are relative to, (0, 0) unless the entities move as a formation
+			double originX, originY;
+
+			// The entities' coordinates, relative to the origin
+			std::vector<double> x, y;
+
+			// The entities' velocities
+			std::vector<double> xvel, yvel;
+
+			// The entities' accelerations
+			std::vector<double> xacc, yacc;
+
+			// The entities' diameters
+			std::vector<float> size;
+
+			// The entities' health values
+			std::vector<int> health;
+
+			// Whether or not each entity has been marked for removal
+			std::vector<char> removed;
+
+			// The indices of the entities marked for removal, in the order they were marked
+			std::vector<unsigned int> removals;
+
+			// The handles of the entities
+			std::vector<EntityHandle> handle;
+
+			EntityArray();
+
+			// Get the number of entities in the array, including those marked for removal
+			unsigned int count() const;
+
+			// Make sure the array has room for at least 'capacity' entities
+			void reserve(unsigned int capacity);
+
+			// Append a new entity at the given coordinates in the world, returns its index
+			// If the array is full it grows, logging a warning since it should have been reserved large enough
+			unsigned int add(EntityHandle handle, double x, double y, float size, int health, double xvel = 0, double yvel = 0, double xacc = 0, double yacc = 0);
+
+			// Mark entity i for removal, indices stay valid until compact() is called
+			// Returns false if the entity was already marked
+			bool remove(unsigned int i);
+
+			// Check whether or not entity i has been marked for removal
+			bool isRemoved(unsigned int i) const;
+
+			// Drop every entity marked for removal in a single pass, preserving the order of the rest
+			void compact();
+
+			// Remove every entity
+			void clear();
+
+			// Get the coordinates of entity i in the world
+			double worldX(unsigned int i) const;
+			double worldY(unsigned int i) const;
+
+			// Move the origin, moving every entity along with it
+			void setOrigin(double x, double y);
+
+			// Check whether or not the health value of entity i is 0 or less
+			bool isDead(unsigned int i) const;
+
+			// Write the entities to a snapshot
+			void save(Snapshot& out) const;
+
+			// Read the entities back from a snapshot
+			void load(Snapshot::Reader& in);
+		};
+
+		// A collection of EntityArrays, one for each EntityType, 
+		// with a slot map from generational EntityHandles to each entity's type and index
+		class EntityStore {
+		private:
+			// A slot in the slot map
+			struct Slot {
+				// The type and index of the entity occupying the slot
+				EntityType type;
+				unsigned int index;
+
+				// The slot's current generation, incremented every time it is freed
+				std::uint32_t generation;
+
+				// Whether or not an entity occupies the slot, a full word so that the slot has no padding to snapshot
+				std::uint32_t used;
+			};
+
+			std::array<EntityArray, entityTypeCount> arrays;
+
+			// The slot map
+			std::vector<Slot> slots;
+
+			// The indices of unused slots
+			std::vector<std::uint32_t> freeSlots;
+
+			// Free the slot of a handle, making the handle stale
+			void freeSlot(EntityHandle handle);
+
+		public:
+			EntityStore();
+
+			// Add a new entity of the given type and return its handle
+			EntityHandle add(EntityType type, double x, double y, float size, int health, double xvel = 0, double yvel = 0, double xacc = 0, double yacc = 0);
+
+			// Make sure there's room for at least 'capacity' entities of the given type, without allocating during play
+			void reserve(EntityType type, unsigned int capacity);
+
+			// Check whether or not a handle refers to an entity that still exists
+			bool isValid(EntityHandle handle) const;
+
+			// Get the type of the entity a handle refers to
+			EntityType getType(EntityHandle handle) const;
+
+			// Get the index of the entity a handle refers to within its EntityArray
+			// Throws if the handle is stale
+			unsigned int getIndex(EntityHandle handle) const;
+
+			// Drop every entity marked for removal, freeing their handles
+			void compact();
+
+			// Get the array holding every entity of the given type
+			EntityArray& operator[](EntityType type);
+			const EntityArray& operator[](EntityType type) const;
+
+			// Get the total number of entities
+			unsigned int count() const;
+
+			// Fill 'out' with an EntityObserver for every entity not marked for removal, in a single pass over the arrays
+			// The entities are ordered by type, and keep their order within their type
+			void observe(std::vector<EntityObserver>& out) const;
+
+			// Remove every entity
+			void clear();
+
+			// Write every entity and the slot map to a snapshot
+			void save(Snapshot& out) const;
+
+			// Read every entity and the slot map back from a snapshot
+			void load(Snapshot::Reader& in);
+		};
+
+	}
+}
@@ -8,8 +8,36 @@ namespace SI {
 
 		PeriodTimer::PeriodTimer(double period, std::shared_ptr<Stopwatch> stopwatch) :
 			period((unsigned long long)(period*1e9f)),
-			timePoint(std::chrono::high_resolution_clock::now()),
-			stopwatch(stopwatch) {}
+			timePoint(stopwatch->now()),
+			stopwatch(stopwatch)
+		{
+			schedule();
+		}
+
+		PeriodTimer::PeriodTimer(const PeriodTimer& other) :
+			stopwatch(other.stopwatch),
+			timePoint(other.timePoint),
+			period(other.period)
+		{
+			schedule();
+		}
+
+		PeriodTimer& PeriodTimer::operator=(const PeriodTimer& other) {
+			stopwatch->getTimers().cancel(deadline);
+			stopwatch = other.stopwatch;
+			timePoint = other.timePoint;
+			period = other.period;
+			schedule();
+			return *this;
+		}
+
+		PeriodTimer::~PeriodTimer() {
+			stopwatch->getTimers().cancel(deadline);
+		}
+
+		void PeriodTimer::schedule() {
+			stopwatch->getTimers().schedule(deadline, timePoint + std::chrono::duration_cast<TimePoint::duration>(std::chrono::nanoseconds(period)));
+		}
 
 		double PeriodTimer::getPeriod() const {
 			return (double)this->period / 1e9f;
@@ -17,30 +45,44 @@ namespace SI {
 
 		void PeriodTimer::setPeriod(double period) {
 			this->period = (unsigned long long)(period * 1e9f);
+			schedule();
 		}
 
 		void PeriodTimer::reset(){
 			timePoint = stopwatch->now();
+			schedule();
+		}
+
+		TimePoint PeriodTimer::getDeadline() const {
+			return deadline.deadline;
 		}
 
 		double PeriodTimer::timePassed() {
 			return nanoToSeconds(stopwatch->now() - timePoint);
 		}
 
+		void PeriodTimer::save(Snapshot& out) const {
+			out.write(timePoint);
+			out.write(period);
+		}
+
+		void PeriodTimer::load(Snapshot::Reader& in) {
+			in.read(timePoint);
+			in.read(period);
+			schedule();
+		}
+
 		// BinaryRepeatTimer : PeriodTimer
 
 		BinaryRepeatTimer::BinaryRepeatTimer(double period, std::shared_ptr<Stopwatch> stopwatch) :
 			PeriodTimer(period, stopwatch) {}
 
 		bool BinaryRepeatTimer::operator()() {
-			auto now = stopwatch->now();
-			if ((unsigned long long)(now - timePoint).count() < period) {
+			if (!deadline.expired)
 				return false;
-			}
-			else {
-				timePoint = now;
-				return true;
-			}
+			timePoint = stopwatch->now();
+			schedule();
+			return true;
 		}
 		
 		// CountingRepeatTimer : PeriodTimer
@@ -50,32 +92,48 @@ namespace SI {
 			periods(0) {}
 
 		void CountingRepeatTimer::setPeriod(double period) {
-			timePoint = TimePoint(std::chrono::nanoseconds(timePoint.time_since_epoch().count() + periods*this->period));
-			this->period = (unsigned long long)(period * 1e9f);
 			periods = 0;
+			PeriodTimer::setPeriod(period);
 		}
 
 		void CountingRepeatTimer::reset() {
-			timePoint = stopwatch->now();
 			periods = 0;
+			PeriodTimer::reset();
 		}
 
 		bool CountingRepeatTimer::operator()() {
-			auto now = stopwatch->now();
-			if ((now - timePoint).count() - periods*period < period)
+			if (!deadline.expired)
 				return false;
 
+			// The point in time moves along with every period counted, so the deadline is always the end of the next one
+			timePoint += std::chrono::duration_cast<TimePoint::duration>(std::chrono::nanoseconds(period));
 			periods++;
+			schedule();
 			return true;
 		}
 
 		unsigned int CountingRepeatTimer::count(){
+			if (!deadline.expired)
+				return 0;
+
 			// Calculate the additional ones that might fit in the open time
-			auto diff = (((stopwatch->now() - timePoint).count()) / period) - periods;
+			auto diff = (unsigned long long)(stopwatch->now() - timePoint).count() / period;
+			timePoint += std::chrono::duration_cast<TimePoint::duration>(std::chrono::nanoseconds(diff * period));
 			periods += (unsigned int)diff;
+			schedule();
 			return (unsigned int)diff;
 		}
 
+		void CountingRepeatTimer::save(Snapshot& out) const {
+			PeriodTimer::save(out);
+			out.write(periods);
+		}
+
+		void CountingRepeatTimer::load(Snapshot::Reader& in) {
+			PeriodTimer::load(in);
+			in.read(periods);
+		}
+
 		// WithinPeriodTimer : PeriodTimer
 
 		WithinPeriodTimer::WithinPeriodTimer(double period, bool forceFalseState, std::shared_ptr<Stopwatch> stopwatch) :
@@ -91,7 +149,17 @@ namespace SI {
 		}
 
 		bool WithinPeriodTimer::operator()(){
-			return !forceFalseState && ((unsigned long long)(stopwatch->now() - timePoint).count() < period);
+			return !forceFalseState && !deadline.expired;
+		}
+
+		void WithinPeriodTimer::save(Snapshot& out) const {
+			PeriodTimer::save(out);
+			out.write(forceFalseState);
+		}
+
+		void WithinPeriodTimer::load(Snapshot::Reader& in) {
+			PeriodTimer::load(in);
+			in.read(forceFalseState);
 		}
 	}
 }
\ No newline at end of file
@@ -7,14 +7,26 @@ namespace SI {
 		// An interface for objects which return 'true' when called if certain conditions
 		// regarding a given period, a past point in time and the current point in time
 		// are met, working based off the time given by a certain Stopwatch.
+		// Every timer registers the moment 'period' seconds after its point in time with the stopwatch's TimerWheel,
+		// so checking a timer doesn't have to ask the stopwatch for the time, it only sees time pass when the
+		// stopwatch's timers are updated though
 		class PeriodTimer {
 		protected:
 			std::shared_ptr<Stopwatch> stopwatch;
 			TimePoint timePoint;
 			unsigned long long period;
 
+			// The moment 'period' seconds after the point in time, as registered with the stopwatch's timer wheel
+			TimerWheel::Entry deadline;
+
+			// Register the deadline with the stopwatch's timer wheel again, after the point in time or period changed
+			void schedule();
+
 		public:
 			PeriodTimer(double period, std::shared_ptr<Stopwatch> stopwatch = GlobalStopwatch::getInstance());
+			PeriodTimer(const PeriodTimer& other);
+			PeriodTimer& operator=(const PeriodTimer& other);
+			virtual ~PeriodTimer();
 
 			// Get the timer's period
 			double getPeriod() const;
@@ -29,6 +41,15 @@ namespace SI {
 
 			// Get the amount of 'available' time
 			virtual double timePassed();
+
+			// Get the moment 'period' seconds after the timer's point in time, by its stopwatch
+			TimePoint getDeadline() const;
+
+			// Write the state to a snapshot
+			virtual void save(Snapshot& out) const;
+
+			// Read the state back from a snapshot
+			virtual void load(Snapshot::Reader& in);
 		};
 
 		// A timer which returns 'true' when called if it has been longer than 'period' seconds since the last 
@@ -65,6 +86,13 @@ namespace SI {
 			// Takes up all the periods that still fit in the time since its creation, returns their count.
 			// Adds that count of periods to the count
 			virtual unsigned int count();
+
+			// Write the state to a snapshot
+			virtual void save(Snapshot& out) const;
+
+			// Read the state back from a snapshot
+			virtual void load(Snapshot::Reader& in);
+
 		};
 
 		// A timer that checks if it's been less than 'period' time since its creation or the last reset
@@ -84,6 +112,13 @@ namespace SI {
 
 			// Check if it has been less than 'period' seconds since the last reset() call
 			virtual bool operator()();
+
+			// Write the state to a snapshot
+			virtual void save(Snapshot& out) const;
+
+			// Read the state back from a snapshot
+			virtual void load(Snapshot::Reader& in);
+
 		};
 	}
 }
@@ -20,4 +20,25 @@ namespace SI {
 		return x - fmod;
 	}
 
+	void writeVarint(std::vector<std::uint8_t>& out, std::uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back(std::uint8_t(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(std::uint8_t(value));
+	}
+
+	std::uint64_t readVarint(const std::vector<std::uint8_t>& data, std::size_t& offset) {
+		std::uint64_t value = 0;
+		for (unsigned int shift = 0; shift < 64; shift += 7) {
+			if (offset >= data.size())
+				throw(std::runtime_error("Data ends in the middle of a value."));
+			std::uint8_t byte = data[offset++];
+			value |= std::uint64_t(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				return value;
+		}
+		throw(std::runtime_error("Data contains a malformed value."));
+	}
+
 }
\ No newline at end of file
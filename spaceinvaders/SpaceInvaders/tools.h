@@ -38,4 +38,13 @@ namespace SI {
 	// Used for aligning to the fake pixel grid
 	double align(double x, double y);
 
+
+	// Append an unsigned integer to 'out' as a varint: 7 bits per byte, the high bit set on every byte but the last
+	// Used for compact binary formats, such as replays and netplay packets
+	void writeVarint(std::vector<std::uint8_t>& out, std::uint64_t value);
+
+	// Read a varint from 'data' starting at 'offset', moving 'offset' past it
+	// Throws if the data ends in the middle of the varint, or if it's too long to be one
+	std::uint64_t readVarint(const std::vector<std::uint8_t>& data, std::size_t& offset);
+
 }
\ No newline at end of file
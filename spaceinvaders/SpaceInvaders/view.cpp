@@ -22,17 +22,29 @@ namespace SI
 		View::View(double tickPeriod) :
 			stopwatch(Time::GlobalStopwatch::getInstance()),
 			frameTimer(tickPeriod, stopwatch),
-			resources(stopwatch),
 			flickerCounter(0.05f),
-			rng(RNG::RNG::getInstance())
+			resources(stopwatch),
+			sprites(&resources.getSpriteSheetTexture()),
+			particles(2048)
 		{
+			textParticles.reserve(32);
+
 			// Create window
 			window = std::make_shared<sf::RenderWindow>(sf::VideoMode(800, 720), "Space Invaders");
-			observer = std::make_shared<Md::ModelObserver>();
+			feed = std::make_shared<Md::ModelFeed>();
+			observer = &feed->read();
+		}
+
+		std::shared_ptr<Md::ModelFeed> View::getFeed() {
+			return feed;
 		}
 
-		std::shared_ptr<Md::ModelObserver> View::getObserver() {
-			return observer;
+		TimePoint View::getNextFrame() const {
+			return frameTimer.getDeadline();
+		}
+
+		bool View::isOpen() const {
+			return window->isOpen();
 		}
 
 		void View::update() {
@@ -42,6 +54,10 @@ namespace SI
 
 			double dt = stopwatch->tick();
 
+			// Take the latest state the model published
+			feed->update();
+			observer = &feed->read();
+
 			// Check if the window is closed
 			checkWindowEvents();
 
@@ -56,11 +72,15 @@ namespace SI
 			// Draw the background
 			window->draw(resources.getBackgroundSprite());
 			
-			// Draw the entities
-			for (std::shared_ptr<Md::EntityObserver> e : observer->getEntityObservers()) {
-				switch (e->getType()) {
+			// Draw the entities as far along from their previous to their latest positions as the time is along to the next step,
+			// so that they move smoothly even if the model steps less often than frames are drawn
+			// The players are observed in the order of their numbers
+			observer->interpolateEntities(feed->getStepFraction(stopwatch->now()), drawnEntities);
+			unsigned int players = 0;
+			for (const Md::EntityObserver& e : drawnEntities) {
+				switch (e.getType()) {
 				case Md::EntityType::player:
-					drawPlayer(e);
+					drawPlayer(e, players++);
 					break;
 				case Md::EntityType::smallEnemy:
 					drawSmallEnemy(e);
@@ -82,13 +102,14 @@ namespace SI
 				}
 			}
 
+			// Draw the lives of the HUD along with the entities, so that every sprite is drawn in a single draw call
+			drawLives();
+			sprites.flush(*window);
+
 			// Draw the particles
 			drawParticles();
 
 				// HUD elements:
-			// Draw the lives
-			drawLives();
-
 			// Draw the timer
 			std::string timerText = "TIME: " + std::to_string(observer->getSecondsPassed());
 			drawShadedText(timerText, 20, green3, sf::Vector2f(660, 20), 2, green1);
@@ -139,8 +160,8 @@ namespace SI
 		}
 
 		void View::checkEvents(){
-			std::vector<Md::Event> events = observer->popEvents();
-			for (auto e : events) {
+			Md::Event e;
+			while (feed->popEvent(e)) {
 				switch (e.getType()) {
 				case Md::EventType::friendlyShotFired:
 					resources.playPlayerFireSound();
@@ -198,49 +219,45 @@ namespace SI
 
 		void View::makeParticleExplosion(double x, double y, double speed, unsigned int count, double size, double sized, sf::Color color, double angle, double time) {
 			for (unsigned int i = 0; i < count; ++i)
-				particles.push_back(std::make_shared<Particle>(x, y, speed*std::sin(pi*2*i/count + angle), speed * std::cos(pi * 2 * i / count + angle), size, sized, time, color));
+				particles.add(x, y, speed*std::sin(pi*2*i/count + angle), speed * std::cos(pi * 2 * i / count + angle), size, sized, time, color);
 		}
 
 		void View::makeRandomParticleExplosion(double x, double y, double speed, double speedVar, unsigned int count, double size, double sizeVar, double sized, sf::Color color, double time, double timeVar){
 			for (unsigned int i = 0; i < count; ++i) {
-				double rSpeed = rng->realFromRange(speed-speedVar, speed+speedVar);
-				double angle = rng->realFromRange(0.0, (double)pi * 2);
-				double rSize = rng->realFromRange(size - sizeVar, size + sizeVar);
-				double rTime = rng->realFromRange(time - timeVar, time + timeVar);
-				particles.push_back(std::make_shared<Particle>(x, y, rSpeed*std::sin(angle), rSpeed * std::cos(angle), rSize, sized, rTime, color));
+				double rSpeed = rng.realFromRange(speed-speedVar, speed+speedVar);
+				double angle = rng.realFromRange(0.0, (double)pi * 2);
+				double rSize = rng.realFromRange(size - sizeVar, size + sizeVar);
+				double rTime = rng.realFromRange(time - timeVar, time + timeVar);
+				particles.add(x, y, rSpeed*std::sin(angle), rSpeed * std::cos(angle), rSize, sized, rTime, color);
 				}
 			}
 
 		void View::makeTextParticle(std::string text, double x, double y){
-			particles.push_back(std::make_shared<TextParticle>(text, x, y, 0.0, -40.0, 2.0, green3));
+			textParticles.push_back(TextParticle(text, x, y, 0.0, -40.0, 2.0, green3));
 		}
 
 		void View::tickParticles(double dt){
-			std::vector<std::shared_ptr<Particle>> dead;
-			for (auto& particle : particles) {
-				if (!particle->alive())
-					dead.push_back(particle);
-				else
-					particle->tick(dt);
-			}
-			// Wait with deleting the dead ones until the end, to prevent horrible things from happening
-			for (auto& particle : dead) {
-				particles.erase(std::remove(particles.begin(), particles.end(), particle), particles.end());
+			particles.tick(dt);
+			// Move the last text particle into the place of every dead one
+			for (unsigned int i = 0; i < textParticles.size();) {
+				textParticles[i].tick(dt);
+				if (textParticles[i].alive()) {
+					++i;
+					continue;
+				}
+				if (i != textParticles.size() - 1)
+					textParticles[i] = std::move(textParticles.back());
+				textParticles.pop_back();
 			}
 		}
 
 		// DRAW FUNCTIONS
 
 		void View::drawParticles() {
-			for (auto& p : particles) {
-				if (const auto& e = std::dynamic_pointer_cast<TextParticle>(p)) {
-					drawShadedText(e->getText(), 40, e->getColor(), sf::Vector2f((float)e->getX(), (float)e->getY()), 5);
-				}
-				else {
-					float size = (float)align(p->getSize(), 5.0f);
-					drawRectangle(size, size, p->getColor(), align(p->getX() - size / 2, 5.0f), align(p->getY() - size / 2, 5.0f));
-				}
-			}
+			particles.draw(quads, 5.0f);
+			quads.flush(*window);
+			for (const TextParticle& e : textParticles)
+				drawShadedText(e.getText(), 40, e.getColor(), sf::Vector2f((float)e.getX(), (float)e.getY()), 5);
 		}
 
 		void View::drawLives(){
@@ -251,40 +268,39 @@ namespace SI
 				drawSprite(resources.getLifeSprite(), 320 + i * 60, 20);
 		}
 
-		void View::drawSprite(sf::Sprite& sprite, double x, double y) {
-			sprite.setPosition((float)align(x, 5.0f), (float)align(y,5.0f));
-			window->draw(sprite);
+		void View::drawSprite(const sf::Sprite& sprite, double x, double y) {
+			sprites.addSprite(sprite, (float)align(x, 5.0f), (float)align(y, 5.0f));
 		}
 
-		void View::drawPlayer(std::shared_ptr<Md::EntityObserver> e) {
-			if((flickerCounter.getCount()%2 || !observer->isPlayerInvinc() )&& !observer->isPlayerDead() )	
+		void View::drawPlayer(const Md::EntityObserver& e, unsigned int player) {
+			if((flickerCounter.getCount()%2 || !observer->isPlayerInvinc(player) )&& !observer->isPlayerDead(player) )	
 				// Don't draw the player if he's dead
 				// Don't draw the player if he's invincible and the flicker state is on
-				drawSprite(resources.getPlayerSprite(), e->getXpos() - 40, e->getYpos() - 20);
+				drawSprite(resources.getPlayerSprite(), e.getXpos() - 40, e.getYpos() - 20);
 		}
 
-		void View::drawPlayerBullet(std::shared_ptr<Md::EntityObserver> e) {
-			drawSprite(resources.getPlayerBulletSprite(e->getHealth()), e->getXpos()- 20, e->getYpos() - 20);
+		void View::drawPlayerBullet(const Md::EntityObserver& e) {
+			drawSprite(resources.getPlayerBulletSprite(e.getHealth()), e.getXpos()- 20, e.getYpos() - 20);
 		}
 
-		void View::drawEnemyBullet(std::shared_ptr<Md::EntityObserver> e) {
-			drawSprite(resources.getEnemyBulletSprite(e->getHealth()), e->getXpos() - 20, e->getYpos() - 20);
+		void View::drawEnemyBullet(const Md::EntityObserver& e) {
+			drawSprite(resources.getEnemyBulletSprite(e.getHealth()), e.getXpos() - 20, e.getYpos() - 20);
 		}
 
-		void View::drawSmallEnemy(std::shared_ptr<Md::EntityObserver> e) {
-			drawSprite(resources.getSmallEnemySprite(), e->getXpos() - 40, e->getYpos() - 20);
+		void View::drawSmallEnemy(const Md::EntityObserver& e) {
+			drawSprite(resources.getSmallEnemySprite(), e.getXpos() - 40, e.getYpos() - 20);
 		}
 
-		void View::drawBigEnemy(std::shared_ptr<Md::EntityObserver> e){
-			drawSprite(resources.getBigEnemySprite(), e->getXpos() - 40, e->getYpos() - 40);
+		void View::drawBigEnemy(const Md::EntityObserver& e){
+			drawSprite(resources.getBigEnemySprite(), e.getXpos() - 40, e.getYpos() - 40);
 		}
 		
-		void View::drawBarrier(std::shared_ptr<Md::EntityObserver> e) {
-			drawSprite(resources.getBarrierSprite(e->getHealth()), e->getXpos() - 20, e->getYpos() - 20);
+		void View::drawBarrier(const Md::EntityObserver& e) {
+			drawSprite(resources.getBarrierSprite(e.getHealth()), e.getXpos() - 20, e.getYpos() - 20);
 		}
 
-		void View::drawPowerup(std::shared_ptr<Md::EntityObserver> e){
-			drawSprite(resources.getPowerupSprite(), e->getXpos() - 20, e->getYpos() - 20);
+		void View::drawPowerup(const Md::EntityObserver& e){
+			drawSprite(resources.getPowerupSprite(), e.getXpos() - 20, e.getYpos() - 20);
 		}
 
 		void View::drawText(std::string text, unsigned int size, sf::Color color, sf::Vector2f position) {
@@ -347,10 +363,7 @@ namespace SI
 		}
 
 		void View::drawRectangle(float width, float height, sf::Color color, double x, double y) {
-			sf::RectangleShape shape(sf::Vector2f(width, height));
-			shape.setFillColor(color);
-			shape.setPosition(sf::Vector2f((float)x , (float)y));
-			window->draw(shape);
+			quads.addRectangle((float)x, (float)y, width, height, color);
 		}
 
 		void View::drawDebugText(double dt){
@@ -363,13 +376,18 @@ namespace SI
 			text = "Entities: " + std::to_string(observer->getEntityCount());
 			drawShadedText(text, 12, sf::Color::Yellow, sf::Vector2f(4, 16), 2);
 
-			// Draw the entity count
-			text = "Entity Observers: " + std::to_string(observer->getEntityObservers().size());
+			// Draw the size of the entity snapshot
+			text = "Entity Observers: " + std::to_string(observer->getEntities().size());
 			drawShadedText(text, 12, sf::Color::Yellow, sf::Vector2f(4, 28), 2);
 
 			// Draw the particle count
-			text = "Particles: " + std::to_string(particles.size());
+			text = "Particles: " + std::to_string(particles.getCount() + textParticles.size());
 			drawShadedText(text, 12, sf::Color::Yellow, sf::Vector2f(4, 40), 2);
+
+			// Draw the room for particles
+			text = "Particle room: " + std::to_string(particles.getCount()) + "/" + std::to_string(particles.getCapacity())
+				+ " (peak " + std::to_string(particles.getHighWaterMark()) + ")";
+			drawShadedText(text, 12, sf::Color::Yellow, sf::Vector2f(4, 52), 2);
 		}
 		
 	}
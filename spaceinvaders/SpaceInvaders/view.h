@@ -1,17 +1,20 @@
 #pragma once
 
 #include "StdAfx.h"
+#include <SFML/Graphics.hpp>
 #include "resources.h"
-#include "model.h"
+#include "observer.h"
+#include "feed.h"
 #include "time.h"
+#include "random.h"
 #include "particle.h"
 #include "tools.h"
+#include "batch.h"
 
 namespace SI
 {
 	namespace Md {
-		class Model;
-		class ModelObserver;
+		class MirrorObserver;
 	}
 
 	namespace Vw {
@@ -33,11 +36,17 @@ namespace SI
 			// The window to which things get drawn
 			std::shared_ptr<sf::RenderWindow> window;
 
-			// The observer which observes our model, and contains the information we need
-			std::shared_ptr<Md::ModelObserver> observer;
+			// The model's state as published by the thread simulating it
+			std::shared_ptr<Md::ModelFeed> feed;
 
-			// The RNG provider
-			std::shared_ptr<RNG::RNG> rng;
+			// The latest state taken from the feed, which contains the information we need
+			const Md::MirrorObserver* observer;
+
+			// The entities drawn in the current frame, in between their positions of the model's last two steps
+			std::vector<Md::EntityObserver> drawnEntities;
+
+			// The view's RNG, used for cosmetic effects only
+			RNG::RNG rng;
 
 			// The global timer
 			std::shared_ptr<Time::GlobalStopwatch> stopwatch;
@@ -51,8 +60,13 @@ namespace SI
 			// A class that loads, stores and provides the various texture and sound resources
 			Resources resources;
 
-			// A vector of particles
-			std::vector<std::shared_ptr<Particle>> particles;
+			// The sprites of the sprite sheet and the plain quads of the particles, each drawn in a single draw call when flushed
+			SpriteBatch sprites;
+			SpriteBatch quads;
+
+			// The live particles, and the few live text particles in a list of their own
+			ParticleSystem particles;
+			std::vector<TextParticle> textParticles;
 
 			// Debug:
 			// A simple object that keeps track of the average framerate out of every 120 samples
@@ -63,16 +77,22 @@ namespace SI
 			// Create a view with a certain minimum period between frames
 			View(double tickPeriod = 0.0);
 
-			// Get a pointer to the observer so it can be registered in a model
-			std::shared_ptr<Md::ModelObserver> getObserver();
+			// Get the feed the model's state is published to for the view
+			std::shared_ptr<Md::ModelFeed> getFeed();
 
 			// Draw everything based off the observer's data
 			void update();
 
+			// Get the moment the next frame is due, by the global stopwatch
+			TimePoint getNextFrame() const;
+
+			// Check whether or not the window is still open
+			bool isOpen() const;
+
 			// Check window events, so the window can close properly
 			void checkWindowEvents();
 
-			// Perform actions based off the events stored in the observer
+			// Perform actions based off the events published to the feed
 			void checkEvents();
 
 			// Create a circular set of particles to simulate an explosion
@@ -83,7 +103,7 @@ namespace SI
 
 			void makeTextParticle(std::string text, double x, double y);
 
-			// Tick every particle
+			// Tick every particle and text particle, removing the dead ones
 			void tickParticles(double dt);
 			
 			// Drawing functions: 
@@ -95,14 +115,15 @@ namespace SI
 			void drawLives();
 
 				// Entities:
-			void drawSprite(sf::Sprite & sprite, double x, double y);
-			void drawPlayer(std::shared_ptr<Md::EntityObserver> e);
-			void drawSmallEnemy(std::shared_ptr<Md::EntityObserver> e);
-			void drawBigEnemy(std::shared_ptr<Md::EntityObserver> e);
-			void drawPlayerBullet(std::shared_ptr<Md::EntityObserver> e);
-			void drawEnemyBullet(std::shared_ptr<Md::EntityObserver> e);
-			void drawBarrier(std::shared_ptr<Md::EntityObserver> e);
-			void drawPowerup(std::shared_ptr<Md::EntityObserver> e);
+			// Add a sprite of the sprite sheet to the batch of sprites, aligned to the pixel grid, drawn when the batch is flushed
+			void drawSprite(const sf::Sprite& sprite, double x, double y);
+			void drawPlayer(const Md::EntityObserver& e, unsigned int player);
+			void drawSmallEnemy(const Md::EntityObserver& e);
+			void drawBigEnemy(const Md::EntityObserver& e);
+			void drawPlayerBullet(const Md::EntityObserver& e);
+			void drawEnemyBullet(const Md::EntityObserver& e);
+			void drawBarrier(const Md::EntityObserver& e);
+			void drawPowerup(const Md::EntityObserver& e);
 			
 				// Text:
 			void drawText(std::string text, unsigned int size, sf::Color color, sf::Vector2f position);
@@ -111,6 +132,7 @@ namespace SI
 			void drawCenteredShadedText(std::string text, unsigned int size, double ypos, sf::Color color, sf::Color shade, int shadeDistance);
 			
 				// Shapes:
+			// Add a rectangle to the batch of plain quads, drawn when the batch is flushed
 			void drawRectangle(float width, float height, sf::Color color, double x, double y);
 
 				// Debug:
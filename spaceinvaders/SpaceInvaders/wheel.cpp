@@ -0,0 +1,198 @@
+#include "StdAfx.h"
+#include "wheel.h"
+
+namespace SI
+{
+	namespace Time {
+
+	// TimerWheel::Entry
+
+		TimerWheel::Entry::Entry() : expired(false), next(nullptr), prev(nullptr) {}
+
+		TimerWheel::Entry::Entry(const Entry&) : Entry() {}
+
+		TimerWheel::Entry& TimerWheel::Entry::operator=(const Entry&) {
+			// The entry stays registered as it is, its owner decides on its deadline
+			return *this;
+		}
+
+	// TimerWheel
+
+		TimerWheel::TimerWheel() : expired(nullptr), time(std::chrono::seconds(0)), current(0) {
+			for (auto& level : slots)
+				level.fill(nullptr);
+			occupied.fill(0);
+		}
+
+		TimerWheel::~TimerWheel() {
+			// Leave no entry pointing into the wheel
+			for (auto& level : slots)
+				for (Entry*& list : level)
+					while (list)
+						unlink(*list);
+			while (expired)
+				unlink(*expired);
+		}
+
+		std::uint64_t TimerWheel::granule(TimePoint t) {
+			return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count() >> granuleBits;
+		}
+
+		void TimerWheel::link(Entry*& list, Entry& entry) {
+			entry.next = list;
+			if (list)
+				list->prev = &entry.next;
+			entry.prev = &list;
+			list = &entry;
+		}
+
+		void TimerWheel::unlink(Entry& entry) {
+			if (!entry.prev)
+				return;
+			*entry.prev = entry.next;
+			if (entry.next)
+				entry.next->prev = entry.prev;
+			entry.next = nullptr;
+			entry.prev = nullptr;
+		}
+
+		void TimerWheel::insert(Entry& entry) {
+			if (entry.deadline <= time) {
+				entry.expired = true;
+				link(expired, entry);
+				return;
+			}
+			entry.expired = false;
+
+			// The first level whose slots reach far enough ahead, the ones further away than any level reaches
+			// wait in the furthest slot of the last level, and are sorted again once it comes around
+			std::uint64_t g = granule(entry.deadline);
+			unsigned int level = 0;
+			while (level < levels - 1 && g - current >= 1ull << (slotBits * (level + 1)))
+				++level;
+			if (g - current >= 1ull << (slotBits * levels))
+				g = current + (1ull << (slotBits * levels)) - 1;
+
+			unsigned int slot = (g >> (slotBits * level)) & (slotCount - 1);
+			link(slots[level][slot], entry);
+			occupied[level] |= 1ull << slot;
+		}
+
+		void TimerWheel::cascade(unsigned int level, unsigned int slot) {
+			Entry* e = slots[level][slot];
+			if (e)
+				e->prev = nullptr;
+			slots[level][slot] = nullptr;
+			occupied[level] &= ~(1ull << slot);
+			while (e) {
+				Entry* next = e->next;
+				e->next = nullptr;
+				e->prev = nullptr;
+				if (next)
+					next->prev = nullptr;
+				insert(*e);
+				e = next;
+			}
+		}
+
+		void TimerWheel::expireCurrent() {
+			unsigned int slot = current & (slotCount - 1);
+			Entry* e = slots[0][slot];
+			while (e) {
+				Entry* next = e->next;
+				if (e->deadline <= time) {
+					unlink(*e);
+					e->expired = true;
+					link(expired, *e);
+				}
+				e = next;
+			}
+			if (!slots[0][slot])
+				occupied[0] &= ~(1ull << slot);
+		}
+
+		void TimerWheel::rebuild() {
+			// Gather every entry in a single list, then sort them all again
+			Entry* all = nullptr;
+			for (auto& level : slots)
+				for (Entry*& list : level)
+					while (list) {
+						Entry& e = *list;
+						unlink(e);
+						link(all, e);
+					}
+			while (expired) {
+				Entry& e = *expired;
+				unlink(e);
+				link(all, e);
+			}
+			occupied.fill(0);
+			while (all) {
+				Entry& e = *all;
+				unlink(e);
+				insert(e);
+			}
+		}
+
+		void TimerWheel::schedule(Entry& entry, TimePoint deadline) {
+			unlink(entry);
+			entry.deadline = deadline;
+			insert(entry);
+		}
+
+		void TimerWheel::cancel(Entry& entry) {
+			unlink(entry);
+		}
+
+		void TimerWheel::advance(TimePoint now) {
+			if (now <= time)
+				return;
+			std::uint64_t target = granule(now);
+			time = now;
+			if (target - current >= 1ull << (slotBits * levels)) {
+				// Further than the wheel reaches, it's quicker to start over
+				current = target;
+				rebuild();
+				return;
+			}
+
+			expireCurrent();
+			while (current < target) {
+				// Skip ahead to right before the next granule that any slot could have to be looked at in
+				unsigned int empty = 0;
+				while (empty < levels && !occupied[empty])
+					++empty;
+				if (empty == levels) {
+					current = target;
+					break;
+				}
+				if (empty > 0) {
+					std::uint64_t last = current | ((1ull << (slotBits * empty)) - 1);
+					if (last >= target) {
+						current = target;
+						break;
+					}
+					current = last;
+				}
+
+				++current;
+				// Move the deadlines that have come close enough down from the coarser levels, coarsest first
+				for (unsigned int level = levels - 1; level > 0; --level)
+					if ((current & ((1ull << (slotBits * level)) - 1)) == 0)
+						cascade(level, (current >> (slotBits * level)) & (slotCount - 1));
+				expireCurrent();
+			}
+		}
+
+		void TimerWheel::reset(TimePoint now) {
+			time = now;
+			current = granule(now);
+			rebuild();
+		}
+
+		TimePoint TimerWheel::now() const {
+			return time;
+		}
+
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "StdAfx.h"
+
+typedef std::chrono::time_point<std::chrono::high_resolution_clock> TimePoint;
+
+namespace SI
+{
+	namespace Time {
+
+		// A hierarchical timer wheel, keeping track of which of a number of deadlines have passed
+		// Deadlines are sorted into slots of about a millisecond, with coarser levels of slots for deadlines further away
+		// that are moved down a level as they come closer, so advancing the wheel only looks at the deadlines that pass
+		// and the slots in between, no matter how many deadlines are waiting
+		// Every Stopwatch owns one, which the timers based on it register their deadlines with
+		class TimerWheel {
+		public:
+			// A deadline registered with the wheel, part of the object waiting on it
+			// Entries don't own anything, copying one gives an entry that isn't registered
+			struct Entry {
+				// The moment the deadline passes
+				TimePoint deadline;
+
+				// Whether or not the deadline has passed, by the time the wheel was last advanced to
+				bool expired;
+
+				// The next entry in the same list, and the pointer pointing to this entry, or nullptr if unregistered
+				Entry* next;
+				Entry** prev;
+
+				Entry();
+				Entry(const Entry& other);
+				Entry& operator=(const Entry& other);
+			};
+
+		private:
+			// The number of bits of a time point in nanoseconds below the granule, a granule is about a millisecond
+			static const unsigned int granuleBits = 20;
+
+			// The number of levels, and the number of bits of a granule each level's slots are indexed by
+			static const unsigned int levels = 4;
+			static const unsigned int slotBits = 6;
+			static const unsigned int slotCount = 1 << slotBits;
+
+			// The lists of entries in every slot of every level
+			std::array<std::array<Entry*, slotCount>, levels> slots;
+
+			// For every level, a bit for every slot telling whether or not it holds any entries
+			std::array<std::uint64_t, levels> occupied;
+
+			// The list of entries whose deadline has passed
+			Entry* expired;
+
+			// The time point the wheel was last advanced to, and its granule
+			TimePoint time;
+			std::uint64_t current;
+
+			// Get the granule containing a time point
+			static std::uint64_t granule(TimePoint t);
+
+			// Link an entry into a list
+			static void link(Entry*& list, Entry& entry);
+
+			// Unlink an entry from whichever list it is in
+			static void unlink(Entry& entry);
+
+			// Put a registered but unlinked entry into the slot or list its deadline belongs in
+			void insert(Entry& entry);
+
+			// Unlink every entry in a slot and insert it again, moving it down to a finer level
+			void cascade(unsigned int level, unsigned int slot);
+
+			// Expire the entries in the slot of the current granule whose deadline has passed
+			void expireCurrent();
+
+			// Unlink and insert every entry again, after time has jumped too far or moved backwards
+			void rebuild();
+
+		public:
+			TimerWheel();
+			~TimerWheel();
+
+			TimerWheel(const TimerWheel&) = delete;
+			TimerWheel& operator=(const TimerWheel&) = delete;
+
+			// Register an entry with the given deadline, or move it to the given deadline if it's already registered
+			// A deadline that has already passed expires the entry straight away
+			void schedule(Entry& entry, TimePoint deadline);
+
+			// Unregister an entry
+			void cancel(Entry& entry);
+
+			// Move the wheel forward to the given time point, expiring every entry whose deadline has passed
+			void advance(TimePoint now);
+
+			// Move the wheel to the given time point, even backwards, updating whether or not every entry has expired
+			void reset(TimePoint now);
+
+			// Get the time point the wheel was last advanced to
+			TimePoint now() const;
+		};
+
+	}
+}